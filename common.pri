@@ -1 +1,2 @@
-INCLUDEPATH += $$PWD/imageEditorApp/src/common/
+INCLUDEPATH += $$PWD/imageEditorApp/src/common/ \
+               $$PWD/imageEditorApp/src/render/
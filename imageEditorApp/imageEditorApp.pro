@@ -1,5 +1,5 @@
 QT   += core gui opengl
-LIBS += -lGL
+LIBS += -lGL -lz
   
 ! include(../common.pri) {
     error( "Couldn't find the common.pri file!" )
@@ -38,9 +38,11 @@ Debug:MOC_DIR = debug/.moc
 SOURCES += $$files(src/view/*.cpp) \
            $$files(src/model/*.cpp) \
            $$files(src/persistence/*.cpp) \
+           $$files(src/render/*.cpp) \
            $$files(src/common/*.cpp)
 HEADERS += $$files(src/view/*.h) \
            $$files(src/model/*.h) \
            $$files(src/persistence/*.h) \
+           $$files(src/render/*.h) \
            $$files(src/common/*.h)
 FORMS += res/mainwindow.ui
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+
+// CacheStats: counters of the decoded image cache, of the display's texture cache and of the tiles of a virtual
+//             texture, used to report how well prefetching, keeping the textures of the history and paging work
+struct CacheStats
+{
+    std::size_t hits{ 0u };
+    std::size_t misses{ 0u };
+    std::size_t prefetched{ 0u };   // images decoded in the background
+    std::size_t images{ 0u };       // images, textures or tiles currently cached
+    std::size_t bytes{ 0u };        // memory held by the cached images or textures
+    std::size_t budget{ 0u };
+
+    auto hitRate() const -> double
+    {
+        const auto total = hits + misses;
+        return total == 0u ? 0.0 : static_cast<double>(hits) / static_cast<double>(total);
+    }
+};
@@ -0,0 +1,23 @@
+#pragma once
+
+// ColorData: the parameters of the color and intensity operations
+//            red, green and blue are in [0, 1], where 0.5 leaves the channel unchanged,
+//            bright is added to the luma, and contrast is the exponent of the contrast curve
+struct ColorData
+{
+    float red{ 0.5f };
+    float green{ 0.5f };
+    float blue{ 0.5f };
+    float bright{ 0.0f };
+    float contrast{ 1.0f };
+};
+
+inline auto operator==(const ColorData& a, const ColorData& b) -> bool
+{
+    return a.red == b.red && a.green == b.green && a.blue == b.blue && a.bright == b.bright && a.contrast == b.contrast;
+}
+
+inline auto operator!=(const ColorData& a, const ColorData& b) -> bool
+{
+    return !(a == b);
+}
@@ -0,0 +1,96 @@
+#include "dirtyregion.h"
+
+#include <limits>
+
+const std::size_t DirtyRegion::maxRects{ 16u };
+
+void DirtyRegion::add(const QRect& rect)
+{
+    auto dirty = rect.intersected(bounds);
+    if (dirty.isEmpty())
+        return;
+
+    // merging can make the rectangle touch others, which have already been checked, so start over
+    auto merged = true;
+    while (merged)
+    {
+        merged = false;
+
+        for (auto it = rects.begin(); it != rects.end(); ++it)
+        {
+            if (it->contains(dirty))
+                return;
+
+            // adjacent rectangles are merged too, to avoid uploading a row or column at a time
+            const auto united = dirty.united(*it);
+            if (dirty.adjusted(-1, -1, 1, 1).intersects(*it) && area(united) <= area(dirty) + area(*it))
+            {
+                dirty = united;
+                rects.erase(it);
+                merged = true;
+                break;
+            }
+        }
+    }
+
+    rects.push_back(dirty);
+
+    while (rects.size() > maxRects)
+        mergeCheapestPair();
+}
+
+void DirtyRegion::setBounds(const QRect& bounds)
+{
+    this->bounds = bounds;
+    rects.clear();
+}
+
+auto DirtyRegion::take() -> std::vector<QRect>
+{
+    auto result = std::vector<QRect>{};
+    result.swap(rects);
+    return result;
+}
+
+auto DirtyRegion::getArea() const -> long long
+{
+    auto sum = 0ll;
+    for (const auto& rect : rects)
+        sum += area(rect);
+
+    return sum;
+}
+
+// merges the two rectangles whose union adds the least clean area
+void DirtyRegion::mergeCheapestPair()
+{
+    auto bestWaste = std::numeric_limits<long long>::max();
+    auto first     = std::size_t{ 0u };
+    auto second    = std::size_t{ 1u };
+
+    for (std::size_t i = 0; i < rects.size(); ++i)
+    {
+        for (auto j = i + 1; j < rects.size(); ++j)
+        {
+            const auto waste = area(rects[i].united(rects[j])) - area(rects[i]) - area(rects[j]);
+            if (waste < bestWaste)
+            {
+                bestWaste = waste;
+                first     = i;
+                second    = j;
+            }
+        }
+    }
+
+    const auto united = rects[first].united(rects[second]);
+    rects.erase(rects.begin() + long(second));
+    rects.erase(rects.begin() + long(first));
+
+    // the union may now cover or touch other rectangles
+    add(united);
+}
+
+auto DirtyRegion::area(const QRect& rect) -> long long
+{
+    return static_cast<long long>(rect.width()) * rect.height();
+}
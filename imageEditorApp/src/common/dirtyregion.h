@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vector>
+#include <QRect>
+
+// DirtyRegion: Collects the changed areas of an image, so that only those are uploaded to its texture.
+//              A new rectangle is merged with the ones it touches, as long as their union is not larger
+//              than the two together, and the number of rectangles is kept at maxRects at most, since
+//              every rectangle costs an upload of its own.
+class DirtyRegion
+{
+public:
+    static const std::size_t maxRects;
+
+    explicit DirtyRegion(const QRect& bounds = {}) : bounds{ bounds } { }
+
+    void add(const QRect& rect);
+    void setBounds(const QRect& bounds);
+    auto take() -> std::vector<QRect>;
+
+    auto getRects() const -> const std::vector<QRect>& { return rects; }
+    auto isEmpty() const -> bool                       { return rects.empty(); }
+    auto getArea() const -> long long;
+
+private:
+    QRect              bounds;
+    std::vector<QRect> rects;
+
+    void mergeCheapestPair();
+
+    static auto area(const QRect& rect) -> long long;
+};
@@ -1,20 +1,33 @@
 #pragma once
 
+#include <cachestats.h>
+#include <projectdata.h>
+
 #include <optional>
 #include <QImage>
 #include <QString>
+#include <QStringList>
 
 class IDataAccess
 {
 public:
     static const QImage::Format imageFormat;
+    static const int            defaultCompressionLevel;
 
     virtual ~IDataAccess() { }
 
     virtual auto loadImage(const QString& filepath) -> std::optional<QImage> = 0;
-    virtual void saveImage(const QString& filepath) const = 0;
+    virtual auto saveImage(const QString& filepath) const -> bool = 0;
     virtual auto getImage() const -> std::optional<QImage> = 0;
     virtual void appendHistory(QImage image) = 0;
     virtual auto undo() -> std::optional<QImage> = 0;
     virtual auto redo() -> std::optional<QImage> = 0;
+    virtual auto loadProject(const QString& filepath) -> std::optional<ProjectData> = 0;
+    virtual auto saveProject(const QString& filepath, const std::optional<LayerState>& layer) const -> bool = 0;
+    virtual void setCompressionLevel(int level) = 0;
+    virtual void prefetchImages(const QStringList& filepaths) = 0;
+    virtual auto getCacheStats() const -> CacheStats = 0;
+    virtual auto getRecentFiles() const -> QStringList = 0;
+    virtual void addRecentFile(const QString& filepath) = 0;
+    virtual auto loadThumbnail(const QString& filepath) const -> std::optional<QImage> = 0; // thread safe
 };
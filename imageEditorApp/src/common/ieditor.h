@@ -1,8 +1,13 @@
 #pragma once
 
+#include <cachestats.h>
+#include <colordata.h>
+#include <projectdata.h>
+
 #include <QImage>
 #include <QObject>
 #include <QString>
+#include <QStringList>
 #include <QVector3D>
 #include <optional>
 
@@ -12,15 +17,29 @@ public:
     virtual ~IEditor() { }
 
     enum InterpMethod { NEAREST, BILINEAR, COUNT };
+    enum class MergeBackend { CPU, GPU };
 
     virtual auto loadImage(const QString& filepath) -> std::optional<QImage> = 0;
-    virtual void saveImage(const QString& filepath) const = 0;
+    virtual auto saveImage(const QString& filepath) const -> bool = 0;
     virtual auto getImage() const -> std::optional<QImage> = 0;
+    virtual void prefetchImages(const QStringList& filepaths) = 0;
+    virtual auto getCacheStats() const -> CacheStats = 0;
+    virtual auto getRecentFiles() const -> QStringList = 0;
+    virtual void addRecentFile(const QString& filepath) = 0;
+    virtual auto loadThumbnail(const QString& filepath) const -> std::optional<QImage> = 0; // thread safe
 
     virtual void appendHistory(QImage image) = 0;
     virtual auto undo() -> std::optional<QImage> = 0;
     virtual auto redo() -> std::optional<QImage> = 0;
 
+    virtual auto loadProject(const QString& filepath) -> std::optional<ProjectData> = 0;
+    virtual auto saveProject(const QString& filepath, const std::optional<LayerState>& layer) const -> bool = 0;
+
     virtual void setInterpolationMethod(InterpMethod value) = 0;
+    virtual void setMergeBackend(MergeBackend backend) = 0;     // the CPU is used if the GPU is not available
+    virtual auto getMergeBackend() const -> MergeBackend = 0;
+    virtual void setCompressionLevel(int level) = 0;
     virtual auto mergeImages(QImage lower, QImage upper, const QRect& upperRect, float upperAngle) -> QImage = 0;
+    virtual auto adjustColors(const QImage& image, const ColorData& data) -> QImage = 0;
+    virtual auto toGrayscale(const QImage& image) -> QImage = 0;
 };
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <optional>
+#include <QImage>
+#include <QRect>
+#include <QVector3D>
+
+// LayerState: a pending copy or cut operation, which has not been merged into the image yet
+struct LayerState
+{
+    enum Kind { COPY, CUT };
+
+    Kind      kind{ COPY };
+    QImage    image;
+    QRect     sourcePosition;
+    QVector3D translate;        // zoom independent, in the display's normalized coordinates
+    float     rotate{ 0.0f };
+};
+
+// ProjectData: the state of the editor restored from a project file
+struct ProjectData
+{
+    QImage                    image;
+    std::optional<LayerState> layer;
+};
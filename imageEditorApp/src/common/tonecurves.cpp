@@ -0,0 +1,63 @@
+#include "tonecurves.h"
+#include <util.h>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace util::types;
+
+const int ToneCurves::channelSize{ 256 };
+const int ToneCurves::contrastSize{ 4096 };
+
+namespace
+{
+    template <typename F>
+    auto sample(int size, F curve) -> std::vector<float>
+    {
+        auto table = std::vector<float>(static_cast<std::size_t>(size));
+        for (std::size_t i = 0; i < table.size(); ++i)
+            table[i] = curve(toFloat(i) / toFloat(size - 1));
+
+        return table;
+    }
+}
+
+ToneCurves::ToneCurves(const ColorData& data)
+    : red{ sample(channelSize, [&](float ch) { return channel(ch, data.red); }) }
+    , green{ sample(channelSize, [&](float ch) { return channel(ch, data.green); }) }
+    , blue{ sample(channelSize, [&](float ch) { return channel(ch, data.blue); }) }
+    , contrastCurve{ sample(contrastSize, [&](float ch) { return contrast(ch, data.contrast); }) }
+{
+}
+
+auto ToneCurves::sampleContrast(float ch) const -> float
+{
+    const auto pos   = std::clamp(ch, 0.0f, 1.0f) * toFloat(contrastSize - 1);
+    const auto index = std::min(toInt(pos), contrastSize - 2);
+    const auto t     = pos - toFloat(index);
+
+    const auto i = static_cast<std::size_t>(index);
+    return contrastCurve[i] * (1.0f - t) + contrastCurve[i + 1u] * t;
+}
+
+auto ToneCurves::channel(float ch, float level) -> float
+{
+    if (level < 0.5f)
+        return 2.0f * ch * level;
+    else
+        return 2.0f * (1.0f - ch) * level + 2.0f * ch - 1.0f;
+}
+
+// a = c / (c * 0.5^(c - 1)) of the original shader is simplified to 2^(c - 1),
+// which also gives the limit of the curve (0.5) instead of NaN for c = 0
+auto ToneCurves::contrast(float ch, float level) -> float
+{
+    const auto a = std::pow(2.0f, level - 1.0f);
+
+    if (ch < 0.5f)
+        return a * std::pow(ch, level);
+    else if (ch > 0.5f)
+        return 1.0f - a * std::pow(1.0f - ch, level);
+    else
+        return ch;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <colordata.h>
+
+#include <vector>
+
+// ToneCurves: The curves of the color and intensity operations, sampled into lookup tables.
+//             The channel curves map the 8-bit RGB values, so they have an entry for each of them.
+//             The contrast curve is applied to the luma and chroma after the conversion to YCbCr,
+//             which are not 8-bit values anymore, so it is sampled finer and interpolated linearly.
+//             The brightness is not a curve, it is added to the luma after the contrast.
+class ToneCurves
+{
+public:
+    static const int channelSize;
+    static const int contrastSize;
+
+    explicit ToneCurves(const ColorData& data);
+
+    auto getRed() const -> const std::vector<float>&      { return red; }
+    auto getGreen() const -> const std::vector<float>&    { return green; }
+    auto getBlue() const -> const std::vector<float>&     { return blue; }
+    auto getContrast() const -> const std::vector<float>& { return contrastCurve; }
+
+    // ch is in [0, 1], interpolates between the two nearest entries, like a linearly filtered texture
+    auto sampleContrast(float ch) const -> float;
+
+    // the curves themselves, every value is in [0, 1]
+    static auto channel(float ch, float level) -> float;
+    static auto contrast(float ch, float level) -> float;
+
+private:
+    std::vector<float> red;
+    std::vector<float> green;
+    std::vector<float> blue;
+    std::vector<float> contrastCurve;
+};
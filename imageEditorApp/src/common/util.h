@@ -2,10 +2,17 @@
 
 #include "logger.h"
 
+#include <algorithm>
 #include <cmath>
+#include <condition_variable>
 #include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <stdexcept>
+#include <thread>
+#include <vector>
 #include <QRect>
 #include <QPoint>
 #include <QVector3D>
@@ -125,6 +132,7 @@ namespace util
     //          Redo returns the next action, or the current one, if the size of the collection is MaxSize - 1.
     //          Current returns the current action, identified by the current value of index.
     //          Size returns the current number of held actions.
+    //          Position returns the index of the current action.
     template <typename T, uint MaxSize>
     class history
     {
@@ -146,6 +154,7 @@ namespace util
             auto back()          -> T&             { return data.back(); }
             auto current() const -> T              { return data[index]; }
             auto size() const    -> unsigned int   { return data.size(); }
+            auto position() const -> unsigned int  { return index; }
 
             auto begin()         -> iterator       { return data.begin(); }
             auto begin() const   -> const_iterator { return data.begin(); }
@@ -184,6 +193,151 @@ namespace util
             }
     };
 
+    // lazy: Holds a value that is only produced by its loader function on first access.
+    //       Copies share their state, so the loader runs at most once, and it is released
+    //       right after, along with everything it captured. A lazy can also be made from
+    //       an already existing value, in which case it never calls a loader at all.
+    template <typename T>
+    class lazy
+    {
+        private:
+            struct state
+            {
+                std::optional<T>   value;
+                std::function<T()> loader;
+            };
+
+            std::shared_ptr<state> s;
+
+        public:
+            lazy() : lazy(T{}) { }
+            lazy(T value) : s{ std::make_shared<state>() } { s->value = std::move(value); }
+            explicit lazy(std::function<T()> loader) : s{ std::make_shared<state>() } { s->loader = std::move(loader); }
+
+            auto isLoaded() const -> bool { return s->value.has_value(); }
+
+            auto get() const -> const T&
+            {
+                if (!s->value)
+                {
+                    s->value = s->loader();
+                    s->loader = nullptr;
+                }
+
+                return *s->value;
+            }
+    };
+
+    // serial_scope: While one lives on a thread, parallel_for runs the calls made from that thread on it, in order.
+    //               For threads that are one of many workers already, e.g. the ones of the batch mode, which
+    //               would otherwise each spread their work over all the hardware threads again.
+    class serial_scope
+    {
+        public:
+            serial_scope()  { ++depth(); }
+            ~serial_scope() { --depth(); }
+
+            serial_scope(const serial_scope&) = delete;
+            serial_scope& operator=(const serial_scope&) = delete;
+
+            static auto isActive() -> bool { return depth() > 0; }
+
+        private:
+            static auto depth() -> int&
+            {
+                static thread_local int value{ 0 };
+                return value;
+            }
+    };
+
+    // parallel_for: Calls func for every index in [0, count), spreading the indices over
+    //               the available hardware threads, unless a serial_scope is active on the calling thread.
+    //               Returns when every call has finished.
+    //               The calls must be independent of each other, as their order is unspecified.
+    static inline void parallel_for(std::size_t count, const std::function<void(std::size_t)>& func)
+    {
+        const auto threadCount = serial_scope::isActive()
+                                 ? std::size_t{ 1u }
+                                 : std::min<std::size_t>(count, std::max(1u, std::thread::hardware_concurrency()));
+        if (threadCount <= 1)
+        {
+            for (std::size_t i = 0; i < count; ++i)
+                func(i);
+            return;
+        }
+
+        auto workers = std::vector<std::thread>{};
+        workers.reserve(threadCount - 1);
+
+        // every thread, including the calling one, takes each threadCount-th index
+        const auto work = [&](std::size_t first) {
+            for (auto i = first; i < count; i += threadCount)
+                func(i);
+        };
+
+        for (std::size_t t = 1; t < threadCount; ++t)
+            workers.emplace_back(work, t);
+
+        work(0);
+
+        for (auto& worker : workers)
+            worker.join();
+    }
+
+    // blocking_queue: A thread safe FIFO queue with a maximum capacity, to pass work between threads.
+    //                 Push blocks while the queue is full, and pop blocks while it is empty.
+    //                 After close is called, push fails, and pop returns the remaining items,
+    //                 then an empty optional once the queue has been drained.
+    template <typename T>
+    class blocking_queue
+    {
+        private:
+            std::deque<T>           data{};
+            std::size_t             capacity;
+            bool                    closed{ false };
+            std::mutex              mutex{};
+            std::condition_variable notEmpty{};
+            std::condition_variable notFull{};
+
+        public:
+            explicit blocking_queue(std::size_t capacity) : capacity{ std::max<std::size_t>(1u, capacity) } { }
+
+            auto push(T value) -> bool
+            {
+                auto lock = std::unique_lock<std::mutex>{ mutex };
+                notFull.wait(lock, [this] { return closed || data.size() < capacity; });
+
+                if (closed)
+                    return false;
+
+                data.push_back(std::move(value));
+                notEmpty.notify_one();
+                return true;
+            }
+
+            auto pop() -> std::optional<T>
+            {
+                auto lock = std::unique_lock<std::mutex>{ mutex };
+                notEmpty.wait(lock, [this] { return closed || !data.empty(); });
+
+                if (data.empty())
+                    return std::nullopt;
+
+                auto value = std::move(data.front());
+                data.pop_front();
+                notFull.notify_one();
+                return value;
+            }
+
+            void close()
+            {
+                auto lock = std::unique_lock<std::mutex>{ mutex };
+                closed = true;
+                notEmpty.notify_all();
+                notFull.notify_all();
+            }
+    };
+
     // wrapper functions for the rounding operations, returning ints instead of longs
     template<typename T> static inline auto floor(T k) { return static_cast<int>(std::floor(k)); }
     template<typename T> static inline auto round(T k) { return static_cast<int>(std::round(k)); }
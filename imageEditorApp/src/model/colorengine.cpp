@@ -0,0 +1,202 @@
+#include "colorengine.h"
+#include <idataaccess.h>
+#include <tonecurves.h>
+#include <util.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+using namespace util::types;
+
+namespace
+{
+    const float half{ 128.0f / 255.0f };
+    const int   blockRows{ 32 };       // per task, so that a task is worth its scheduling
+
+    using Table = std::array<float, 256>;
+
+    template <typename F>
+    auto makeTable(F func) -> Table
+    {
+        auto table = Table{};
+        for (std::size_t i = 0; i < table.size(); ++i)
+            table[i] = func(toFloat(i) / 255.0f);
+
+        return table;
+    }
+
+    // Kernel: The operations of ColorEngine::applyPixel on lookup tables. Every 8-bit channel gets a table
+    //         of its contribution to Y, Cb and Cr with its curve already applied, so the conversion to YCbCr
+    //         only adds three entries. The contrast curve is applied afterwards, to values which are not
+    //         8-bit anymore, so it is interpolated from ToneCurves like the shader's texture. The rows are
+    //         processed in passes over float buffers, so that the arithmetic passes can be vectorized by the
+    //         compiler; only the table lookups are scalar.
+    class Kernel
+    {
+    public:
+        explicit Kernel(const ColorData& data)
+            : curves{ data }
+            , contrast{ data.contrast != ColorData{}.contrast }
+            , bright{ data.bright }
+        {
+            const auto& red = curves.getRed();
+            const auto& green = curves.getGreen();
+            const auto& blue = curves.getBlue();
+
+            for (std::size_t i = 0; i < 256u; ++i)
+            {
+                yr[i]  =  0.299f  * red[i];   yg[i]  =  0.587f  * green[i]; yb[i]  =  0.114f  * blue[i];
+                cbr[i] = -0.1687f * red[i];   cbg[i] = -0.3313f * green[i]; cbb[i] =  0.5f    * blue[i];
+                crr[i] =  0.5f    * red[i];   crg[i] = -0.4187f * green[i]; crb[i] = -0.0813f * blue[i];
+            }
+        }
+
+        void applyRow(QRgb* line, int width, std::vector<float>& buffer) const
+        {
+            const auto n = static_cast<std::size_t>(width);
+            buffer.resize(3u * n);
+
+            const auto y  = buffer.data();
+            const auto cb = y + n;
+            const auto cr = cb + n;
+
+            // to YCbCr
+            for (std::size_t x = 0; x < n; ++x)
+            {
+                const auto r = std::size_t(qRed(line[x])), g = std::size_t(qGreen(line[x])), b = std::size_t(qBlue(line[x]));
+
+                y[x]  = yr[r] + yg[g] + yb[b];
+                cb[x] = cbr[r] + cbg[g] + cbb[b] + half;
+                cr[x] = crr[r] + crg[g] + crb[b] + half;
+            }
+
+            for (std::size_t x = 0; x < n; ++x)
+            {
+                y[x]  = std::clamp(y[x], 0.0f, 1.0f);
+                cb[x] = std::clamp(cb[x], 0.0f, 1.0f);
+                cr[x] = std::clamp(cr[x], 0.0f, 1.0f);
+            }
+
+            // intensity operations
+            if (contrast)
+            {
+                for (std::size_t x = 0; x < n; ++x)
+                {
+                    y[x]  = curves.sampleContrast(y[x]);
+                    cb[x] = curves.sampleContrast(cb[x]);
+                    cr[x] = curves.sampleContrast(cr[x]);
+                }
+            }
+
+            // back to RGB, std::clamp keeps the values nonnegative, so adding 0.5 rounds them
+            const auto toChannel = [](float ch) { return uint(std::clamp(ch, 0.0f, 1.0f) * 255.0f + 0.5f); };
+
+            for (std::size_t x = 0; x < n; ++x)
+            {
+                const auto y2  = y[x] + bright;
+                const auto cb2 = cb[x] - half;
+                const auto cr2 = cr[x] - half;
+
+                line[x] = (line[x] & 0xff000000u) | (toChannel(y2 + 1.402f * cr2) << 16) |
+                          (toChannel(y2 - 0.3441f * cb2 - 0.7141f * cr2) << 8) | toChannel(y2 + 1.722f * cb2);
+            }
+        }
+
+    private:
+        const ToneCurves curves;
+        const bool       contrast;    // the default contrast is an identity, the shader skips it too
+        const float      bright;
+        Table            yr{}, yg{}, yb{}, cbr{}, cbg{}, cbb{}, crr{}, crg{}, crb{};
+    };
+
+    // calls func for every row of the image, in blocks of rows spread over the hardware threads
+    template <typename F>
+    void forEachRow(QImage& image, F func)
+    {
+        // query the pointer once, since bits() may detach, which is not safe from multiple threads
+        const auto bits   = image.bits();
+        const auto bpl    = image.bytesPerLine();
+        const auto height = image.height();
+        const auto blocks = (height + blockRows - 1) / blockRows;
+
+        util::parallel_for(std::size_t(blocks), [&](std::size_t block) {
+            auto buffer = std::vector<float>{};
+
+            const auto first = toInt(block) * blockRows;
+            for (int row = first; row < std::min(first + blockRows, height); ++row)
+                func(reinterpret_cast<QRgb*>(bits + row * bpl), buffer);
+        });
+    }
+}
+
+auto ColorEngine::isIdentity(const ColorData& data) -> bool
+{
+    // the YCbCr round trip of the shader is not exact, so only the default values are an identity
+    return data == ColorData{};
+}
+
+auto ColorEngine::applyPixel(QRgb pixel, const ColorData& data) -> QRgb
+{
+    const auto r = ToneCurves::channel(toFloat(qRed(pixel))   / 255.0f, data.red);
+    const auto g = ToneCurves::channel(toFloat(qGreen(pixel)) / 255.0f, data.green);
+    const auto b = ToneCurves::channel(toFloat(qBlue(pixel))  / 255.0f, data.blue);
+
+    // to YCbCr
+    const auto y  = std::clamp( 0.299f  * r + 0.587f  * g + 0.114f  * b       , 0.0f, 1.0f);
+    const auto cb = std::clamp(-0.1687f * r - 0.3313f * g + 0.5f    * b + half, 0.0f, 1.0f);
+    const auto cr = std::clamp( 0.5f    * r - 0.4187f * g - 0.0813f * b + half, 0.0f, 1.0f);
+
+    // intensity operations
+    const auto y2  = ToneCurves::contrast(y, data.contrast) + data.bright;
+    const auto cb2 = ToneCurves::contrast(cb, data.contrast) - half;
+    const auto cr2 = ToneCurves::contrast(cr, data.contrast) - half;
+
+    // back to RGB, with the same coefficients as the shader
+    const auto toChannel = [](float ch) { return util::round(std::clamp(ch, 0.0f, 1.0f) * 255.0f); };
+
+    return qRgba(toChannel(y2 + 1.402f * cr2),
+                 toChannel(y2 - 0.3441f * cb2 - 0.7141f * cr2),
+                 toChannel(y2 + 1.722f * cb2),
+                 qAlpha(pixel));
+}
+
+auto ColorEngine::apply(const QImage& image, const ColorData& data) -> QImage
+{
+    auto result = image.convertToFormat(IDataAccess::imageFormat);
+    if (isIdentity(data))
+        return result;
+
+    const auto kernel = Kernel{ data };
+    const auto width  = result.width();
+
+    forEachRow(result, [&](QRgb* line, std::vector<float>& buffer) { kernel.applyRow(line, width, buffer); });
+
+    return result;
+}
+
+auto ColorEngine::grayscale(const QImage& image) -> QImage
+{
+    auto result = image.convertToFormat(IDataAccess::imageFormat);
+
+    // the luma of the grayscale shader, without any curves
+    static const auto yr = makeTable([](float ch) { return 0.299f * ch; });
+    static const auto yg = makeTable([](float ch) { return 0.587f * ch; });
+    static const auto yb = makeTable([](float ch) { return 0.114f * ch; });
+
+    const auto width = result.width();
+
+    forEachRow(result, [&](QRgb* line, std::vector<float>&) {
+        for (int x = 0; x < width; ++x)
+        {
+            const auto y = std::clamp(yr[std::size_t(qRed(line[x]))] + yg[std::size_t(qGreen(line[x]))] +
+                                      yb[std::size_t(qBlue(line[x]))], 0.0f, 1.0f);
+            const auto v = uint(y * 255.0f + 0.5f);
+
+            line[x] = (line[x] & 0xff000000u) | (v << 16) | (v << 8) | v;
+        }
+    });
+
+    return result;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <colordata.h>
+
+#include <QImage>
+
+// ColorEngine: CPU implementation of the color and intensity operations of the display's fragment shader
+//              (see renderer-shaders.cpp), for when the image is processed without a display. applyPixel
+//              evaluates the curves themselves, apply runs on lookup tables like the shader does, and matches
+//              both within one 8-bit step. The rows are processed on every hardware thread.
+class ColorEngine
+{
+public:
+    static auto isIdentity(const ColorData& data) -> bool;
+    static auto applyPixel(QRgb pixel, const ColorData& data) -> QRgb;
+    static auto apply(const QImage& image, const ColorData& data) -> QImage;
+
+    // the luma of every pixel, like the display's grayscale shader
+    static auto grayscale(const QImage& image) -> QImage;
+};
@@ -30,25 +30,50 @@
 
 void Editor::setInterpolationMethod(InterpMethod method)
 {
+    interpMethod = method;
+
     switch (method)
     {
         case InterpMethod::NEAREST:  interpFunc = Interpolator::nearest;  break;
         case InterpMethod::BILINEAR: interpFunc = Interpolator::bilinear; break;
         default:
             Logger::warning(QString{ "Invalid method passed to " } + __func__ + "!");
-            interpFunc = Interpolator::nearest;
+            interpFunc   = Interpolator::nearest;
+            interpMethod = InterpMethod::NEAREST;
     }
 }
 
 auto Editor::mergeImages(QImage lower, QImage upper, const QRect& upperRect, float upperAngle) -> QImage
 {
-    const auto start  = std::chrono::system_clock::now();
+    const auto start = std::chrono::system_clock::now();
+
+    auto result = std::optional<QImage>{};
+    if (mergeBackend == MergeBackend::GPU)
+    {
+        if (const auto& merger = gpuMerger.get())
+            result = merger->merge(lower, upper, upperRect, upperAngle, interpMethod);
+
+        if (!result)
+            Logger::warning("Merging on the GPU is not available, falling back to the CPU");
+    }
+
+    if (!result)
+        result = mergeOnCpu(std::move(lower), upper, upperRect, upperAngle);
+
+    const auto end = std::chrono::system_clock::now();
+    Logger::toView("Action executed for " + getDuration(start, end));
+
+    return *result;
+}
+
+auto Editor::mergeOnCpu(QImage lower, const QImage& upper, const QRect& upperRect, float upperAngle) -> QImage
+{
     const auto offset = QPointF{ upperRect.topLeft() };
 
-    // QImage would perform a copy of the image if bits() would be called, so we
-    // need to query constBits() and cast away its constness to avoid this copy
-    auto data = reinterpret_cast<QRgb*>(const_cast<uchar*>(lower.constBits()));
-    
+    // bits() only copies the pixels if the caller still shares them, e.g. with the history or the image cache,
+    // which must keep theirs; the merged image gets a cache key of its own, so the display uploads it again
+    auto data = reinterpret_cast<QRgb*>(lower.bits());
+
     for (int i = 0; i < lower.height(); ++i)
     {
         for (int j = 0; j < lower.width(); ++j)
@@ -59,13 +84,28 @@ auto Editor::mergeImages(QImage lower, QImage upper, const QRect& upperRect, flo
                 *pixel = interpFunc(Cell{ revp - offset, upper, *pixel });
         }
     }
-    
-    const auto end = std::chrono::system_clock::now();
-    Logger::toView("Action executed for " + getDuration(start, end));
 
     return lower;
 }
 
+auto Editor::adjustColors(const QImage& image, const ColorData& data) -> QImage
+{
+    START_TIMER
+    auto result = ColorEngine::apply(image, data);
+    STOP_TIMER
+
+    return result;
+}
+
+auto Editor::toGrayscale(const QImage& image) -> QImage
+{
+    START_TIMER
+    auto result = ColorEngine::grayscale(image);
+    STOP_TIMER
+
+    return result;
+}
+
 // rotate p by -upperAngle around upperRect's center
 auto Editor::reverseRotate(const QPoint& p, const QRect& upperRect, float upperAngle) -> QPointF
 {
@@ -2,9 +2,13 @@
 
 #include <ieditor.h>
 #include <dataaccessfactory.h>
+#include "colorengine.h"
+#include "gpumerger.h"
 #include "interpolator.h"
+#include <util.h>
 
 #include <functional>
+#include <memory>
 #include <optional>
 #include <qimage.h>
 
@@ -13,6 +17,7 @@ class Editor : public virtual IEditor
 public:
     explicit Editor(InterpMethod interpMethod, bool debug)
         : dataAccess{ fact::makeDataAccess() }
+        , gpuMerger{ std::function<std::unique_ptr<GpuMerger>()>{ GpuMerger::create } }
         , debug{ debug }
     {
         setInterpolationMethod(interpMethod);
@@ -22,19 +27,46 @@ public:
     
     // inherited via IEditor
     virtual auto loadImage(const QString& filepath) -> std::optional<QImage> override { return dataAccess->loadImage(filepath); }
-    virtual void saveImage(const QString& filepath) const override                    { dataAccess->saveImage(filepath); }
+    virtual auto saveImage(const QString& filepath) const -> bool override            { return dataAccess->saveImage(filepath); }
     virtual auto getImage() const -> std::optional<QImage> override                   { return dataAccess->getImage(); }
+    virtual void prefetchImages(const QStringList& filepaths) override               { dataAccess->prefetchImages(filepaths); }
+    virtual auto getCacheStats() const -> CacheStats override                         { return dataAccess->getCacheStats(); }
+    virtual auto getRecentFiles() const -> QStringList override                       { return dataAccess->getRecentFiles(); }
+    virtual void addRecentFile(const QString& filepath) override                      { dataAccess->addRecentFile(filepath); }
+
+    virtual auto loadThumbnail(const QString& filepath) const -> std::optional<QImage> override
+    {
+        return dataAccess->loadThumbnail(filepath);
+    }
     virtual void appendHistory(QImage image) override                                 { dataAccess->appendHistory(image); }
     virtual auto undo() -> std::optional<QImage> override                             { return dataAccess->undo(); }
     virtual auto redo() -> std::optional<QImage> override                             { return dataAccess->redo(); }
+
+    virtual auto loadProject(const QString& filepath) -> std::optional<ProjectData> override
+    {
+        return dataAccess->loadProject(filepath);
+    }
+
+    virtual auto saveProject(const QString& filepath, const std::optional<LayerState>& layer) const -> bool override
+    {
+        return dataAccess->saveProject(filepath, layer);
+    }
     
     virtual void setInterpolationMethod(InterpMethod method) override;
+    virtual void setMergeBackend(MergeBackend backend) override { mergeBackend = backend; }
+    virtual auto getMergeBackend() const -> MergeBackend override { return mergeBackend; }
+    virtual void setCompressionLevel(int level) override { dataAccess->setCompressionLevel(level); }
     virtual auto mergeImages(QImage lower, QImage upper, const QRect& upperRect, float upperAngle) -> QImage override;
+    virtual auto adjustColors(const QImage& image, const ColorData& data) -> QImage override;
+    virtual auto toGrayscale(const QImage& image) -> QImage override;
 
 private:
-    std::unique_ptr<IDataAccess>     dataAccess;
-    std::function<QRgb(const Cell&)> interpFunc;
-    bool                             debug;
+    std::unique_ptr<IDataAccess>           dataAccess;
+    std::function<QRgb(const Cell&)>       interpFunc;
+    InterpMethod                           interpMethod{ InterpMethod::NEAREST };
+    MergeBackend                           mergeBackend{ MergeBackend::CPU };
+    util::lazy<std::unique_ptr<GpuMerger>> gpuMerger;    // its context is only created once the GPU is used
+    bool                                   debug;
 
     static inline auto getDuration(const std::chrono::time_point<std::chrono::system_clock>& start,
                                    const std::chrono::time_point<std::chrono::system_clock>& end) -> QString
@@ -42,5 +74,7 @@ private:
         return QString::number(std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()) + "ms";
     }
     
+    auto mergeOnCpu(QImage lower, const QImage& upper, const QRect& upperRect, float upperAngle) -> QImage;
+
     static auto reverseRotate(const QPoint& p, const QRect& upperRect, float upperAngle) -> QPointF;
 };
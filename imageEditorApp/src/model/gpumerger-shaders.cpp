@@ -0,0 +1,90 @@
+#include "gpumerger.h"
+
+const char* const GpuMerger::vertexShaderSource =
+R"END(
+#version 120
+
+attribute vec2 in_Position;
+
+void main(void)
+{
+    gl_Position = vec4(in_Position, 0.0, 1.0);
+};
+)END";
+
+// every fragment is one pixel of the lower image, its coordinates are the ones Editor::mergeImages iterates over
+const char* const GpuMerger::fragmentShaderSource =
+R"END(
+#version 120
+
+uniform sampler2D lower;
+uniform sampler2D upper;
+
+uniform vec2 lowerSize;
+uniform vec2 upperSize;
+uniform vec4 upperRect;     // left, top, right, bottom, all inclusive like QRect
+uniform vec2 center;        // the center of upperRect, rounded down like QRect::center
+uniform vec2 rotation;      // cosine and sine of the reverse rotation
+uniform int  bilinear;
+
+// rounds halfway cases away from zero, like std::round
+vec2 roundAway(vec2 v)
+{
+    return sign(v) * floor(abs(v) + 0.5);
+}
+
+vec4 texel(sampler2D image, vec2 size, vec2 pixel)
+{
+    return texture2D(image, (pixel + 0.5) / size);
+}
+
+// the pixels outside of the upper image take the color of the lower one, like Cell does
+vec4 upperTexel(vec2 pixel, vec4 extrapColor)
+{
+    if (pixel.x < 0.0 || pixel.y < 0.0 || pixel.x >= upperSize.x || pixel.y >= upperSize.y)
+        return extrapColor;
+
+    return texel(upper, upperSize, pixel);
+}
+
+void main(void)
+{
+    vec2 pixel = gl_FragCoord.xy - 0.5;
+    vec4 lowerColor = texel(lower, lowerSize, pixel);
+
+    vec2 d = pixel - center;
+    vec2 revp = vec2(rotation.x * d.x - rotation.y * d.y, rotation.y * d.x + rotation.x * d.y) + center;
+    vec2 r = roundAway(revp);
+
+    if (r.x < upperRect.x || r.y < upperRect.y || r.x > upperRect.z || r.y > upperRect.w)
+    {
+        gl_FragColor = lowerColor;
+        return;
+    }
+
+    vec2 p = revp - upperRect.xy;
+    vec2 lo = floor(p);
+    vec2 hi = ceil(p);
+    vec2 q = p - lo;
+
+    vec4 leftTop     = upperTexel(vec2(lo.x, lo.y), lowerColor);
+    vec4 rightTop    = upperTexel(vec2(hi.x, lo.y), lowerColor);
+    vec4 leftBottom  = upperTexel(vec2(lo.x, hi.y), lowerColor);
+    vec4 rightBottom = upperTexel(vec2(hi.x, hi.y), lowerColor);
+
+    if (bilinear != 0)
+    {
+        // Interpolator::bilinear drops the alpha channel
+        vec3 top    = mix(leftTop.rgb, rightTop.rgb, q.x);
+        vec3 bottom = mix(leftBottom.rgb, rightBottom.rgb, q.x);
+        gl_FragColor = vec4(mix(top, bottom, q.y), 1.0);
+    }
+    else
+    {
+        vec2 n = floor(q + 0.5);
+        vec4 top    = n.x > 0.0 ? rightTop : leftTop;
+        vec4 bottom = n.x > 0.0 ? rightBottom : leftBottom;
+        gl_FragColor = n.y > 0.0 ? bottom : top;
+    }
+};
+)END";
@@ -0,0 +1,203 @@
+#ifdef _WIN32
+#  define _USE_MATH_DEFINES
+#endif
+#include <cmath>
+
+#include "gpumerger.h"
+#include <logger.h>
+#include <util.h>
+
+#include <algorithm>
+#include <array>
+#include <QGuiApplication>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLFunctions>
+#include <QOpenGLTexture>
+#include <QVector2D>
+#include <QVector4D>
+
+using namespace util::types;
+
+const int GpuMerger::vertexAttribLoc{ 0 };
+
+namespace
+{
+    // makes a context current for its lifetime, and restores the previous one afterwards
+    class CurrentContext
+    {
+    public:
+        explicit CurrentContext(QOpenGLContext& context, QSurface& surface)
+            : previous{ QOpenGLContext::currentContext() }
+            , previousSurface{ previous ? previous->surface() : nullptr }
+            , made{ context.makeCurrent(&surface) }
+            , context{ context } { }
+
+        ~CurrentContext()
+        {
+            if (previous && previousSurface)
+                previous->makeCurrent(previousSurface);
+            else
+                context.doneCurrent();
+        }
+
+        CurrentContext(const CurrentContext&) = delete;
+        CurrentContext& operator=(const CurrentContext&) = delete;
+
+        auto isMade() const -> bool { return made; }
+
+    private:
+        QOpenGLContext* const previous;
+        QSurface* const       previousSurface;
+        const bool            made;
+        QOpenGLContext&       context;
+    };
+
+    auto makeTexture(const QImage& image) -> std::unique_ptr<QOpenGLTexture>
+    {
+        auto texture = std::make_unique<QOpenGLTexture>(image, QOpenGLTexture::DontGenerateMipMaps);
+
+        texture->setMagnificationFilter(QOpenGLTexture::Nearest);
+        texture->setMinificationFilter(QOpenGLTexture::Nearest);
+        texture->setWrapMode(QOpenGLTexture::ClampToEdge);
+
+        return texture;
+    }
+}
+
+auto GpuMerger::create() -> std::unique_ptr<GpuMerger>
+{
+    // offscreen surfaces need the platform integration of a GUI application
+    if (!qobject_cast<QGuiApplication*>(QCoreApplication::instance()))
+        return nullptr;
+
+    auto merger = std::unique_ptr<GpuMerger>{ new GpuMerger };
+    if (!merger->init())
+        return nullptr;
+
+    return merger;
+}
+
+GpuMerger::~GpuMerger()
+{
+    if (!context || !surface)
+        return;
+
+    // OpenGL objects must be released in their own context
+    const auto current = CurrentContext{ *context, *surface };
+
+    program.reset();
+    vbo.destroy();
+}
+
+auto GpuMerger::init() -> bool
+{
+    context = std::make_unique<QOpenGLContext>();
+    if (!context->create())
+    {
+        Logger::warning("Failed to create an OpenGL context for merging");
+        return false;
+    }
+
+    surface = std::make_unique<QOffscreenSurface>();
+    surface->setFormat(context->format());
+    surface->create();
+
+    const auto current = CurrentContext{ *context, *surface };
+    if (!current.isMade())
+    {
+        Logger::warning("Failed to make the merging context current");
+        return false;
+    }
+
+    context->functions()->glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+
+    program = std::make_unique<QOpenGLShaderProgram>();
+    if (!program->addCacheableShaderFromSourceCode(QOpenGLShader::Vertex, vertexShaderSource))
+    {
+        Logger::warning("Failed to add the merging vertex shader: " + program->log());
+        return false;
+    }
+
+    if (!program->addCacheableShaderFromSourceCode(QOpenGLShader::Fragment, fragmentShaderSource))
+    {
+        Logger::warning("Failed to add the merging fragment shader: " + program->log());
+        return false;
+    }
+
+    program->bindAttributeLocation("in_Position", vertexAttribLoc);
+
+    if (!program->link())
+    {
+        Logger::warning("Failed to link the merging shader: " + program->log());
+        return false;
+    }
+
+    // a quad that covers the whole framebuffer
+    const auto coords = std::array<float, 8>{ -1.0f, -1.0f, 1.0f, -1.0f, 1.0f, 1.0f, -1.0f, 1.0f };
+
+    vbo.create();
+    vbo.bind();
+    vbo.allocate(coords.data(), toInt(coords.size() * sizeof(coords[0])));
+    vbo.release();
+
+    return true;
+}
+
+auto GpuMerger::merge(const QImage& lower, const QImage& upper, const QRect& upperRect, float upperAngle,
+                      IEditor::InterpMethod method) -> std::optional<QImage>
+{
+    if (std::max({ lower.width(), lower.height(), upper.width(), upper.height() }) > maxTextureSize)
+        return {};
+
+    const auto current = CurrentContext{ *context, *surface };
+    if (!current.isMade())
+        return {};
+
+    const auto gl = context->functions();
+
+    auto framebuffer = QOpenGLFramebufferObject{ lower.size(), GL_TEXTURE_2D };
+    if (!framebuffer.bind())
+        return {};
+
+    const auto lowerTexture = makeTexture(lower);
+    const auto upperTexture = makeTexture(upper);
+    lowerTexture->bind(0);
+    upperTexture->bind(1);
+
+    // QMatrix4x4::rotate, which the CPU path uses, takes degrees
+    const auto radians = -upperAngle * toFloat(M_PI) / 180.0f;
+    const auto center  = upperRect.center();
+
+    program->bind();
+    program->setUniformValue("lower", 0);
+    program->setUniformValue("upper", 1);
+    program->setUniformValue("lowerSize", QVector2D{ toFloat(lower.width()), toFloat(lower.height()) });
+    program->setUniformValue("upperSize", QVector2D{ toFloat(upper.width()), toFloat(upper.height()) });
+    program->setUniformValue("upperRect", QVector4D{ toFloat(upperRect.left()), toFloat(upperRect.top()),
+                                                     toFloat(upperRect.right()), toFloat(upperRect.bottom()) });
+    program->setUniformValue("center", QVector2D{ toFloat(center.x()), toFloat(center.y()) });
+    program->setUniformValue("rotation", QVector2D{ std::cos(radians), std::sin(radians) });
+    program->setUniformValue("bilinear", method == IEditor::InterpMethod::BILINEAR ? 1 : 0);
+
+    vbo.bind();
+    program->enableAttributeArray(vertexAttribLoc);
+    program->setAttributeBuffer(vertexAttribLoc, GL_FLOAT, 0, 2, 2 * sizeof(GLfloat));
+
+    gl->glViewport(0, 0, lower.width(), lower.height());
+    gl->glDisable(GL_BLEND);
+    gl->glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+
+    // the framebuffer's rows are in the same order as the image's, so the result needs no mirroring
+    auto result = QImage{ lower.size(), QImage::Format_ARGB32 };
+    gl->glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    gl->glReadPixels(0, 0, result.width(), result.height(), GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, result.bits());
+
+    program->disableAttributeArray(vertexAttribLoc);
+    vbo.release();
+    program->release();
+    upperTexture->release(1);
+    lowerTexture->release(0);
+    framebuffer.release();
+
+    return result;
+}
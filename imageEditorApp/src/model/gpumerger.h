@@ -0,0 +1,48 @@
+#pragma once
+
+#include <ieditor.h>
+
+#include <memory>
+#include <optional>
+#include <QImage>
+#include <QOffscreenSurface>
+#include <QOpenGLBuffer>
+#include <QOpenGLContext>
+#include <QOpenGLShaderProgram>
+#include <QRect>
+
+// GpuMerger: Merges the upper image into the lower one the same way Editor::mergeImages does, but renders
+//            the result with a shader into a framebuffer at the lower image's resolution, then reads it back.
+//            The shader samples the upper image like Interpolator does, so the two only differ by rounding.
+//            It owns an OpenGL context of its own, so that it does not depend on the display being shown,
+//            and it restores the context that was current before each call.
+class GpuMerger
+{
+public:
+    // returns null if there is no GUI application, or no OpenGL context could be created
+    static auto create() -> std::unique_ptr<GpuMerger>;
+
+    ~GpuMerger();
+
+    GpuMerger(const GpuMerger&) = delete;
+    GpuMerger& operator=(const GpuMerger&) = delete;
+
+    // returns nothing if the images are larger than the largest texture of the context
+    auto merge(const QImage& lower, const QImage& upper, const QRect& upperRect, float upperAngle,
+               IEditor::InterpMethod method) -> std::optional<QImage>;
+
+private:
+    static const char* const vertexShaderSource;
+    static const char* const fragmentShaderSource;
+    static const int         vertexAttribLoc;
+
+    std::unique_ptr<QOpenGLContext>       context{ nullptr };
+    std::unique_ptr<QOffscreenSurface>    surface{ nullptr };
+    std::unique_ptr<QOpenGLShaderProgram> program{ nullptr };
+    QOpenGLBuffer                         vbo;
+    int                                   maxTextureSize{ 0 };
+
+    GpuMerger() = default;
+
+    auto init() -> bool;
+};
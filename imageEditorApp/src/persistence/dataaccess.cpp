@@ -1,13 +1,24 @@
 #include "dataaccess.h"
+#include "pngwriter.h"
+#include "projectfile.h"
 
 #include <QDebug>
+#include <QFileInfo>
+#include <QSettings>
 #include <memory>
 
 const QImage::Format IDataAccess::imageFormat{ QImage::Format_ARGB32 };
+const int            IDataAccess::defaultCompressionLevel{ 6 };
+
+namespace
+{
+    const QString recentFilesKey{ "recentFiles" };
+    const int     maxRecentFiles{ 10 };
+}
 
 auto DataAccess::loadImage(const QString& filepath) -> std::optional<QImage>
 {
-    auto img = QImage(filepath).mirrored().convertToFormat(IDataAccess::imageFormat);
+    const auto img = cache.get(filepath);
 
     if (img.isNull())
         return {};
@@ -16,9 +27,18 @@ auto DataAccess::loadImage(const QString& filepath) -> std::optional<QImage>
     return img;
 }
 
-void DataAccess::saveImage(const QString& filepath) const
+auto DataAccess::saveImage(const QString& filepath) const -> bool
 {
-    history->back().mirrored().save(filepath);
+    if (!history)
+        return false;
+
+    const auto img = history->back().get().mirrored();
+
+    // PNGs are deflated on all cores, the other formats are left to Qt
+    if (QFileInfo{ filepath }.suffix().compare("png", Qt::CaseInsensitive) == 0)
+        return PngWriter::write(filepath, img, compressionLevel);
+
+    return img.save(filepath);
 }
 
 auto DataAccess::getImage() const -> std::optional<QImage>
@@ -26,7 +46,7 @@ auto DataAccess::getImage() const -> std::optional<QImage>
     if (!history)
         return {};
     
-    return history->current();
+    return history->current().get();
 }
 
 auto DataAccess::undo() -> std::optional<QImage>
@@ -34,7 +54,11 @@ auto DataAccess::undo() -> std::optional<QImage>
     if (!history)
         return {};
     
-    return history->undo();
+    const auto img = history->undo().get();
+    if (img.isNull())
+        return {};
+
+    return img;
 }
 
 auto DataAccess::redo() -> std::optional<QImage>
@@ -42,7 +66,11 @@ auto DataAccess::redo() -> std::optional<QImage>
     if (!history)
         return {};
     
-    return history->redo();
+    const auto img = history->redo().get();
+    if (img.isNull())
+        return {};
+
+    return img;
 }
 
 void DataAccess::appendHistory(QImage image)
@@ -52,3 +80,76 @@ void DataAccess::appendHistory(QImage image)
 
     history->append(image);
 }
+
+auto DataAccess::loadProject(const QString& filepath) -> std::optional<ProjectData>
+{
+    auto contents = ProjectFile::read(filepath);
+    if (!contents)
+        return {};
+
+    history = std::make_unique<History>(contents->history.front());
+    for (auto it = std::next(contents->history.begin()); it != contents->history.end(); ++it)
+        history->append(*it);
+
+    while (history->position() > contents->current)
+        (void)history->undo();
+
+    return ProjectData{ history->current().get(), std::move(contents->layer) };
+}
+
+auto DataAccess::saveProject(const QString& filepath, const std::optional<LayerState>& layer) const -> bool
+{
+    if (!history)
+        return false;
+
+    auto images = std::vector<QImage>{};
+    for (const auto& img : *history)
+        images.push_back(img.get());
+
+    return ProjectFile::write(filepath, images, history->position(), layer);
+}
+
+void DataAccess::setCompressionLevel(int level)
+{
+    compressionLevel = util::clamp(level, 0, 9);
+}
+
+void DataAccess::prefetchImages(const QStringList& filepaths)
+{
+    cache.prefetch(filepaths);
+}
+
+auto DataAccess::getCacheStats() const -> CacheStats
+{
+    return cache.stats();
+}
+
+// files that have been deleted or moved since are left out
+auto DataAccess::getRecentFiles() const -> QStringList
+{
+    auto files = QStringList{};
+    for (const auto& file : QSettings{}.value(recentFilesKey).toStringList())
+        if (QFileInfo::exists(file))
+            files.append(file);
+
+    return files;
+}
+
+void DataAccess::addRecentFile(const QString& filepath)
+{
+    auto settings = QSettings{};
+    auto files    = settings.value(recentFilesKey).toStringList();
+    const auto absolutePath = QFileInfo{ filepath }.absoluteFilePath();
+
+    files.removeAll(absolutePath);
+    files.prepend(absolutePath);
+    while (files.size() > maxRecentFiles)
+        files.removeLast();
+
+    settings.setValue(recentFilesKey, files);
+}
+
+auto DataAccess::loadThumbnail(const QString& filepath) const -> std::optional<QImage>
+{
+    return thumbnails.thumbnail(filepath);
+}
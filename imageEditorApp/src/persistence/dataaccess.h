@@ -6,6 +6,8 @@
 
 #include <idataaccess.h>
 #include <util.h>
+#include "imagecache.h"
+#include "thumbnailcache.h"
 
 class DataAccess : public virtual IDataAccess
 {
@@ -14,13 +16,25 @@ public:
 
     // inherited via IDataAccess
     virtual auto loadImage(const QString& filepath) -> std::optional<QImage> override;
-    virtual void saveImage(const QString& filepath) const override;
+    virtual auto saveImage(const QString& filepath) const -> bool override;
     virtual auto getImage() const -> std::optional<QImage> override;
     virtual void appendHistory(QImage) override;
     virtual auto undo() -> std::optional<QImage> override;
     virtual auto redo() -> std::optional<QImage> override;
+    virtual auto loadProject(const QString& filepath) -> std::optional<ProjectData> override;
+    virtual auto saveProject(const QString& filepath, const std::optional<LayerState>& layer) const -> bool override;
+    virtual void setCompressionLevel(int level) override;
+    virtual void prefetchImages(const QStringList& filepaths) override;
+    virtual auto getCacheStats() const -> CacheStats override;
+    virtual auto getRecentFiles() const -> QStringList override;
+    virtual void addRecentFile(const QString& filepath) override;
+    virtual auto loadThumbnail(const QString& filepath) const -> std::optional<QImage> override;
 
 private:
-    using History = util::history<QImage, 10u>;
+    // images restored from a project file are only decoded when they are first needed
+    using History = util::history<util::lazy<QImage>, 10u>;
     std::unique_ptr<History> history{ nullptr};
+    int                      compressionLevel{ defaultCompressionLevel };
+    ImageCache               cache;
+    ThumbnailCache           thumbnails;
 };
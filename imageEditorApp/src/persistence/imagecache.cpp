@@ -0,0 +1,159 @@
+#include "imagecache.h"
+#include <idataaccess.h>
+
+#include <QFileInfo>
+
+const std::size_t ImageCache::defaultBudget{ 512u * 1024u * 1024u };
+const unsigned    ImageCache::workerCount{ 2u };
+
+ImageCache::~ImageCache()
+{
+    {
+        auto lock = std::lock_guard<std::mutex>{ mutex };
+        stopping = true;
+        pending.clear();
+    }
+
+    changed.notify_all();
+
+    for (auto& worker : workers)
+        worker.join();
+}
+
+auto ImageCache::get(const QString& filepath) -> QImage
+{
+    const auto key      = toKey(filepath);
+    const auto modified = QFileInfo{ key }.lastModified();
+
+    {
+        auto lock = std::unique_lock<std::mutex>{ mutex };
+
+        // decoding it a second time would only be slower than waiting for the worker
+        changed.wait(lock, [&] { return loading.count(key) == 0u; });
+
+        const auto it = index.find(key);
+        if (it != index.end() && it->second->modified == modified)
+        {
+            entries.splice(entries.begin(), entries, it->second);
+            ++counters.hits;
+            return it->second->image;
+        }
+
+        ++counters.misses;
+        loading.insert(key);
+    }
+
+    const auto image = decode(key);
+
+    {
+        auto lock = std::lock_guard<std::mutex>{ mutex };
+
+        loading.erase(key);
+        if (!image.isNull())
+            insert(key, image, modified);
+    }
+
+    changed.notify_all();
+    return image;
+}
+
+void ImageCache::prefetch(const QStringList& filepaths)
+{
+    {
+        auto lock = std::lock_guard<std::mutex>{ mutex };
+
+        // the neighbours of an image that is not shown anymore are not needed either
+        pending.clear();
+        for (const auto& filepath : filepaths)
+        {
+            const auto key = toKey(filepath);
+            if (index.count(key) == 0u && loading.count(key) == 0u)
+                pending.push_back(key);
+        }
+
+        // the workers are only started once something is prefetched, so that batch jobs do not pay for them
+        while (workers.size() < workerCount)
+            workers.emplace_back(&ImageCache::work, this);
+    }
+
+    changed.notify_all();
+}
+
+auto ImageCache::stats() const -> CacheStats
+{
+    auto lock = std::lock_guard<std::mutex>{ mutex };
+
+    auto result   = counters;
+    result.images = entries.size();
+    result.bytes  = bytes;
+    result.budget = budget;
+
+    return result;
+}
+
+auto ImageCache::decode(const QString& filepath) -> QImage
+{
+    return QImage(filepath).mirrored().convertToFormat(IDataAccess::imageFormat);
+}
+
+auto ImageCache::toKey(const QString& filepath) -> QString
+{
+    return QFileInfo{ filepath }.absoluteFilePath();
+}
+
+// expects the mutex to be locked
+void ImageCache::insert(const QString& key, const QImage& image, const QDateTime& modified)
+{
+    const auto size = std::size_t(image.sizeInBytes());
+    if (size > budget)
+        return;
+
+    const auto it = index.find(key);
+    if (it != index.end())
+    {
+        bytes -= std::size_t(it->second->image.sizeInBytes());
+        entries.erase(it->second);
+        index.erase(it);
+    }
+
+    while (!entries.empty() && bytes + size > budget)
+    {
+        bytes -= std::size_t(entries.back().image.sizeInBytes());
+        index.erase(entries.back().key);
+        entries.pop_back();
+    }
+
+    entries.push_front({ key, image, modified });
+    index[key] = entries.begin();
+    bytes += size;
+}
+
+void ImageCache::work()
+{
+    auto lock = std::unique_lock<std::mutex>{ mutex };
+
+    while (true)
+    {
+        changed.wait(lock, [this] { return stopping || !pending.empty(); });
+        if (stopping)
+            return;
+
+        const auto key = pending.front();
+        pending.pop_front();
+        loading.insert(key);
+
+        lock.unlock();
+        const auto modified = QFileInfo{ key }.lastModified();
+        const auto image    = decode(key);
+        lock.lock();
+
+        loading.erase(key);
+        if (!image.isNull())
+        {
+            insert(key, image, modified);
+            ++counters.prefetched;
+        }
+
+        changed.notify_all();
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cachestats.h>
+
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+#include <QDateTime>
+#include <QImage>
+#include <QString>
+#include <QStringList>
+
+// ImageCache: Keeps recently decoded images in memory, up to a budget in bytes, evicting the least
+//             recently used ones first. Images can be prefetched, in which case they are decoded
+//             by background threads, so that opening them later only takes a lookup.
+//             An entry is dropped when its file has been modified since it was decoded.
+class ImageCache
+{
+public:
+    static const std::size_t defaultBudget;
+    static const unsigned    workerCount;
+
+    explicit ImageCache(std::size_t budget = defaultBudget) : budget{ budget } { }
+    ~ImageCache();
+
+    ImageCache(const ImageCache&) = delete;
+    ImageCache& operator=(const ImageCache&) = delete;
+
+    // returns the image from the cache, or decodes it, waiting for a pending prefetch if there is one
+    // the image shares its data with the cached one, so it must only be written through its non-const accessors
+    auto get(const QString& filepath) -> QImage;
+
+    // replaces the pending prefetches with filepaths, which are decoded in the given order
+    void prefetch(const QStringList& filepaths);
+
+    auto stats() const -> CacheStats;
+
+    // the images are kept in the editor's format and row order
+    static auto decode(const QString& filepath) -> QImage;
+
+private:
+    struct Entry
+    {
+        QString   key;
+        QImage    image;
+        QDateTime modified;
+    };
+
+    using Entries = std::list<Entry>;
+
+    const std::size_t budget;
+
+    mutable std::mutex                   mutex;
+    std::condition_variable              changed;
+    Entries                              entries;    // the most recently used first
+    std::map<QString, Entries::iterator> index;
+    std::deque<QString>                  pending;
+    std::set<QString>                    loading;    // being decoded right now
+    std::vector<std::thread>             workers;
+    bool                                 stopping{ false };
+    std::size_t                          bytes{ 0u };
+    CacheStats                           counters;
+
+    static auto toKey(const QString& filepath) -> QString;
+
+    void insert(const QString& key, const QImage& image, const QDateTime& modified);
+    void work();
+};
@@ -0,0 +1,259 @@
+#include "pngwriter.h"
+#include <logger.h>
+#include <util.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <vector>
+#include <QSaveFile>
+#include <zlib.h>
+
+using namespace util::types;
+
+const std::size_t PngWriter::chunkSize{ 128u * 1024u };
+
+namespace
+{
+    const char        signature[]{ '\x89', 'P', 'N', 'G', '\r', '\n', '\x1a', '\n' };
+    const std::size_t windowSize{ 32u * 1024u };  // the largest dictionary deflate can use
+    const int         windowBits{ -15 };          // raw deflate, the zlib header and checksum are written by hand
+    const int         memLevel{ 8 };
+
+    enum Filter : uchar { NONE, SUB, UP, AVERAGE, PAETH, COUNT };
+
+    // one deflated chunk of the filtered image data
+    struct Chunk
+    {
+        QByteArray data;
+        uLong      adler{ 0u };
+        uLong      length{ 0u };
+        bool       ok{ false };
+    };
+
+    void appendUInt32(QByteArray& out, quint32 value)
+    {
+        const char bytes[]{ char(value >> 24), char(value >> 16), char(value >> 8), char(value) };
+        out.append(bytes, 4);
+    }
+
+    void appendChunk(QByteArray& out, const char* type, const QByteArray& data)
+    {
+        auto crc = crc32(0u, reinterpret_cast<const Bytef*>(type), 4u);
+        crc = crc32(crc, reinterpret_cast<const Bytef*>(data.constData()), uInt(data.size()));
+
+        appendUInt32(out, quint32(data.size()));
+        out.append(type, 4);
+        out.append(data);
+        appendUInt32(out, quint32(crc));
+    }
+
+    auto paeth(int a, int b, int c) -> int
+    {
+        const auto p  = a + b - c;
+        const auto pa = std::abs(p - a);
+        const auto pb = std::abs(p - b);
+        const auto pc = std::abs(p - c);
+
+        if (pa <= pb && pa <= pc)
+            return a;
+
+        return pb <= pc ? b : c;
+    }
+
+    // writes the filter type, then the filtered bytes of row into out, prev is null for the first row
+    void filterRow(Filter filter, const uchar* row, const uchar* prev, std::size_t bytes, std::size_t bpp, uchar* out)
+    {
+        out[0] = filter;
+
+        for (std::size_t i = 0; i < bytes; ++i)
+        {
+            const int left    = i >= bpp ? row[i - bpp] : 0;
+            const int up      = prev ? prev[i] : 0;
+            const int upLeft  = prev && i >= bpp ? prev[i - bpp] : 0;
+
+            auto predicted = 0;
+            switch (filter)
+            {
+                case Filter::SUB:     predicted = left;                   break;
+                case Filter::UP:      predicted = up;                     break;
+                case Filter::AVERAGE: predicted = (left + up) / 2;        break;
+                case Filter::PAETH:   predicted = paeth(left, up, upLeft); break;
+                default:              break;
+            }
+
+            out[i + 1] = uchar(row[i] - predicted);
+        }
+    }
+
+    // picks the filter with the smallest sum of absolute differences, the heuristic libpng uses
+    void filterRowAdaptive(const uchar* row, const uchar* prev, std::size_t bytes, std::size_t bpp, uchar* out)
+    {
+        auto candidate = std::vector<uchar>(bytes + 1u);
+        auto bestCost  = std::numeric_limits<long>::max();
+
+        for (uchar f = Filter::NONE; f < Filter::COUNT; ++f)
+        {
+            filterRow(Filter(f), row, prev, bytes, bpp, candidate.data());
+
+            auto cost = 0l;
+            for (std::size_t i = 1; i <= bytes && cost < bestCost; ++i)
+                cost += std::abs(int(static_cast<signed char>(candidate[i])));
+
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                std::memcpy(out, candidate.data(), bytes + 1u);
+            }
+        }
+    }
+
+    auto isOpaque(const QImage& image) -> bool
+    {
+        for (int y = 0; y < image.height(); ++y)
+        {
+            const auto line = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+            for (int x = 0; x < image.width(); ++x)
+                if (qAlpha(line[x]) != 255)
+                    return false;
+        }
+
+        return true;
+    }
+
+    // deflates data[begin, end), the chunks before the last one end on a byte boundary (sync flush)
+    // instead of closing the stream, so that the outputs of all chunks can simply be concatenated
+    auto deflateChunk(const uchar* data, std::size_t begin, std::size_t end, bool last, int level) -> Chunk
+    {
+        auto chunk  = Chunk{};
+        auto stream = z_stream{};
+
+        if (deflateInit2(&stream, level, Z_DEFLATED, windowBits, memLevel, Z_DEFAULT_STRATEGY) != Z_OK)
+            return chunk;
+
+        // priming with the previous data gives back most of the ratio lost by splitting the stream
+        const auto dictLength = std::min(begin, windowSize);
+        if (dictLength > 0u)
+            deflateSetDictionary(&stream, data + begin - dictLength, uInt(dictLength));
+
+        const auto length = end - begin;
+        chunk.data = QByteArray{ toInt(deflateBound(&stream, uLong(length))) + 16, Qt::Uninitialized };
+
+        stream.next_in   = const_cast<Bytef*>(data + begin);
+        stream.avail_in  = uInt(length);
+        stream.next_out  = reinterpret_cast<Bytef*>(chunk.data.data());
+        stream.avail_out = uInt(chunk.data.size());
+
+        const auto result = deflate(&stream, last ? Z_FINISH : Z_SYNC_FLUSH);
+        chunk.ok = last ? result == Z_STREAM_END : result == Z_OK && stream.avail_in == 0u && stream.avail_out > 0u;
+
+        chunk.data.resize(toInt(stream.total_out));
+        chunk.adler  = adler32(1u, data + begin, uInt(length));
+        chunk.length = uLong(length);
+
+        deflateEnd(&stream);
+        return chunk;
+    }
+
+    // CMF and FLG of the zlib header, FLEVEL is only informative
+    auto zlibHeader(int level) -> QByteArray
+    {
+        const auto cmf    = 0x78;                 // deflate with a 32K window
+        const auto flevel = level < 2 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3;
+        auto flg          = flevel << 6;
+
+        flg += (31 - (cmf * 256 + flg) % 31) % 31;
+
+        return QByteArray{}.append(char(cmf)).append(char(flg));
+    }
+}
+
+auto PngWriter::encode(const QImage& image, int level) -> QByteArray
+{
+    if (image.isNull())
+        return {};
+
+    level = util::clamp(level, 0, 9);
+
+    // PNG rows are stored as RGB(A) bytes, the alpha channel is dropped when it carries no information
+    const auto opaque = isOpaque(image.convertToFormat(QImage::Format_ARGB32));
+    const auto img    = image.convertToFormat(opaque ? QImage::Format_RGB888 : QImage::Format_RGBA8888);
+    const auto bpp    = opaque ? 3u : 4u;
+    const auto width  = std::size_t(img.width());
+    const auto height = std::size_t(img.height());
+    const auto bytes  = width * bpp;
+    const auto stride = bytes + 1u;             // every row starts with its filter type
+
+    auto filtered = std::vector<uchar>(stride * height);
+
+    util::parallel_for(height, [&](std::size_t y) {
+        const auto row  = img.constScanLine(toInt(y));
+        const auto prev = y > 0u ? img.constScanLine(toInt(y) - 1) : nullptr;
+        const auto out  = filtered.data() + y * stride;
+
+        // filtering does not pay off if the data is only stored
+        if (level == 0)
+            filterRow(Filter::NONE, row, prev, bytes, bpp, out);
+        else
+            filterRowAdaptive(row, prev, bytes, bpp, out);
+    });
+
+    const auto chunkCount = (filtered.size() + chunkSize - 1u) / chunkSize;
+    auto chunks = std::vector<Chunk>(chunkCount);
+
+    util::parallel_for(chunkCount, [&](std::size_t i) {
+        const auto begin = i * chunkSize;
+        const auto end   = std::min(begin + chunkSize, filtered.size());
+
+        chunks[i] = deflateChunk(filtered.data(), begin, end, i + 1u == chunkCount, level);
+    });
+
+    auto ihdr = QByteArray{};
+    appendUInt32(ihdr, quint32(width));
+    appendUInt32(ihdr, quint32(height));
+    ihdr.append(char(8));                       // bit depth
+    ihdr.append(char(opaque ? 2 : 6));          // color type, truecolor with or without alpha
+    ihdr.append(char(0)).append(char(0)).append(char(0)); // compression, filter method, interlace
+
+    auto png = QByteArray{ signature, int(sizeof(signature)) };
+    appendChunk(png, "IHDR", ihdr);
+
+    // every chunk becomes an IDAT of its own, the decoder reads them as one stream
+    auto adler = adler32(0u, nullptr, 0u);
+    for (std::size_t i = 0; i < chunkCount; ++i)
+    {
+        if (!chunks[i].ok)
+        {
+            Logger::warning("Failed to compress PNG data!");
+            return {};
+        }
+
+        appendChunk(png, "IDAT", i == 0u ? zlibHeader(level) + chunks[i].data : chunks[i].data);
+        adler = adler32_combine(adler, chunks[i].adler, z_off_t(chunks[i].length));
+    }
+
+    // the checksum of the stream is only known once every chunk is done, so it gets the last IDAT
+    auto trailer = QByteArray{};
+    appendUInt32(trailer, quint32(adler));
+    appendChunk(png, "IDAT", trailer);
+    appendChunk(png, "IEND", {});
+
+    return png;
+}
+
+auto PngWriter::write(const QString& filepath, const QImage& image, int level) -> bool
+{
+    const auto png = encode(image, level);
+    if (png.isEmpty())
+        return false;
+
+    auto file = QSaveFile{ filepath };
+    if (!file.open(QIODevice::WriteOnly) || file.write(png) != png.size() || !file.commit())
+    {
+        Logger::warning("Failed to write " + filepath + ": " + file.errorString());
+        return false;
+    }
+
+    return true;
+}
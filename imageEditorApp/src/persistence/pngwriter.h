@@ -0,0 +1,19 @@
+#pragma once
+
+#include <QByteArray>
+#include <QImage>
+#include <QString>
+
+// PngWriter: Writes PNG files, deflating the image data on all cores.
+//            The filtered rows are cut into chunks of chunkSize bytes, which are compressed
+//            independently, each primed with the end of the previous chunk as its dictionary,
+//            and stitched into the single zlib stream of the file, the same way pigz works.
+//            The level trades speed for size like zlib's: 0 stores, 1 is the fastest, 9 the smallest.
+class PngWriter
+{
+public:
+    static const std::size_t chunkSize;
+
+    static auto write(const QString& filepath, const QImage& image, int level) -> bool;
+    static auto encode(const QImage& image, int level) -> QByteArray;
+};
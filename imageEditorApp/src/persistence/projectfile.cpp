@@ -0,0 +1,402 @@
+#include "projectfile.h"
+#include <idataaccess.h>
+#include <logger.h>
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+
+using namespace util::types;
+
+const QString ProjectFile::suffix{ "iep" };
+const quint32 ProjectFile::magic{ 0x49455046 }; // "IEPF"
+const quint32 ProjectFile::version{ 2u };
+const int     ProjectFile::tileSize{ 256 };
+const int     ProjectFile::compressionLevel{ 1 };
+const int     ProjectFile::thumbnailSize{ 128 };
+
+namespace
+{
+    const int bytesPerPixel{ 4 };
+    const int headerSize{ 8 };   // magic, version
+    const int trailerSize{ 12 }; // index offset, magic
+    const int tileEntrySize{ 12 }; // offset, length
+    const int maxImageSide{ 1 << 20 };
+    const quint32 firstVersion{ 1u }; // without a thumbnail
+
+    // the position of one compressed tile inside the file
+    struct TileEntry
+    {
+        quint64 offset{ 0u };
+        quint32 length{ 0u };
+    };
+
+    struct ImageEntry
+    {
+        qint32                 width{ 0 };
+        qint32                 height{ 0 };
+        std::vector<TileEntry> tiles;
+    };
+
+    // the index of a project file, before anything has been decoded
+    struct Index
+    {
+        std::vector<ImageEntry>   history;
+        quint32                   current{ 0u };
+        std::optional<LayerState> layer;        // without its image
+        ImageEntry                layerEntry;
+        std::optional<ImageEntry> thumbnail;
+    };
+
+    // MappedFile: keeps a project file mapped into memory, for as long as an image may be decoded from it
+    struct MappedFile
+    {
+        QFile  file;
+        uchar* data{ nullptr };
+        qint64 size{ 0 };
+
+        explicit MappedFile(const QString& filepath) : file{ filepath }
+        {
+            if (!file.open(QIODevice::ReadOnly))
+                return;
+
+            size = file.size();
+            data = file.map(0, size);
+        }
+
+        ~MappedFile()
+        {
+            if (data)
+                file.unmap(data);
+        }
+
+        auto bytes(qint64 offset, qint64 length) const -> QByteArray
+        {
+            return QByteArray::fromRawData(reinterpret_cast<const char*>(data + offset), toInt(length));
+        }
+    };
+
+    // tiles are laid out row by row, the ones on the right and bottom edges may be smaller
+    auto tileRects(int width, int height) -> std::vector<QRect>
+    {
+        auto rects = std::vector<QRect>{};
+
+        for (int y = 0; y < height; y += ProjectFile::tileSize)
+            for (int x = 0; x < width; x += ProjectFile::tileSize)
+                rects.emplace_back(x, y, std::min(ProjectFile::tileSize, width - x), std::min(ProjectFile::tileSize, height - y));
+
+        return rects;
+    }
+
+    auto compressTiles(const QImage& image) -> std::vector<QByteArray>
+    {
+        const auto rects = tileRects(image.width(), image.height());
+        const auto bits  = image.constBits();
+        const auto bpl   = image.bytesPerLine();
+
+        auto tiles = std::vector<QByteArray>(rects.size());
+
+        util::parallel_for(rects.size(), [&](std::size_t i) {
+            const auto& rect    = rects[i];
+            const auto rowBytes = rect.width() * bytesPerPixel;
+
+            auto raw = QByteArray{ rowBytes * rect.height(), Qt::Uninitialized };
+            for (int y = 0; y < rect.height(); ++y)
+                std::memcpy(raw.data() + y * rowBytes, bits + (rect.top() + y) * bpl + rect.left() * bytesPerPixel,
+                            std::size_t(rowBytes));
+
+            tiles[i] = qCompress(raw, ProjectFile::compressionLevel);
+        });
+
+        return tiles;
+    }
+
+    auto decodeImage(const MappedFile& mapped, const ImageEntry& entry) -> QImage
+    {
+        const auto rects = tileRects(entry.width, entry.height);
+
+        auto image = QImage{ entry.width, entry.height, IDataAccess::imageFormat };
+        if (image.isNull())
+            return {};
+
+        // query the pointer once, since bits() may detach, which is not safe from multiple threads
+        const auto bits = image.bits();
+        const auto bpl  = image.bytesPerLine();
+
+        auto failed = std::atomic_bool{ false };
+
+        util::parallel_for(rects.size(), [&](std::size_t i) {
+            const auto& rect    = rects[i];
+            const auto& tile    = entry.tiles[i];
+            const auto rowBytes = rect.width() * bytesPerPixel;
+
+            const auto raw = qUncompress(mapped.data + tile.offset, toInt(tile.length));
+            if (raw.size() != rowBytes * rect.height())
+            {
+                failed = true;
+                return;
+            }
+
+            for (int y = 0; y < rect.height(); ++y)
+                std::memcpy(bits + (rect.top() + y) * bpl + rect.left() * bytesPerPixel, raw.constData() + y * rowBytes,
+                            std::size_t(rowBytes));
+        });
+
+        if (failed)
+        {
+            Logger::warning("Corrupt tile found in project file!");
+            return {};
+        }
+
+        return image;
+    }
+
+    void writeEntry(QDataStream& stream, const ImageEntry& entry)
+    {
+        stream << entry.width << entry.height << quint32(entry.tiles.size());
+        for (const auto& tile : entry.tiles)
+            stream << tile.offset << tile.length;
+    }
+
+    // reads an entry, and checks that its tiles are all inside the mapped file; the size and the number of tiles
+    // are checked before anything is allocated for them, since the index of the file may claim anything
+    auto readEntry(QDataStream& stream, const MappedFile& mapped) -> std::optional<ImageEntry>
+    {
+        auto entry = ImageEntry{};
+        auto count = quint32{};
+        stream >> entry.width >> entry.height >> count;
+
+        if (stream.status() != QDataStream::Ok || entry.width <= 0 || entry.height <= 0 ||
+            entry.width > maxImageSide || entry.height > maxImageSide)
+            return {};
+
+        const auto columns = (quint64(entry.width) + quint64(ProjectFile::tileSize) - 1u) / quint64(ProjectFile::tileSize);
+        const auto rows    = (quint64(entry.height) + quint64(ProjectFile::tileSize) - 1u) / quint64(ProjectFile::tileSize);
+        if (count != columns * rows || quint64(count) * quint64(tileEntrySize) > quint64(mapped.size))
+            return {};
+
+        entry.tiles.resize(count);
+        for (auto& tile : entry.tiles)
+        {
+            stream >> tile.offset >> tile.length;
+
+            // the sum of the two may overflow
+            if (tile.offset < quint64(headerSize) || tile.offset > quint64(mapped.size) ||
+                tile.length > quint64(mapped.size) - tile.offset)
+                return {};
+        }
+
+        if (stream.status() != QDataStream::Ok)
+            return {};
+
+        return entry;
+    }
+
+    auto readIndex(const MappedFile& mapped, const QString& filepath) -> std::optional<Index>
+    {
+        if (!mapped.data || mapped.size < headerSize + trailerSize)
+        {
+            Logger::warning("Failed to map project file " + filepath);
+            return {};
+        }
+
+        const auto fail = [&filepath](const QString& reason) -> std::optional<Index> {
+            Logger::warning("Invalid project file " + filepath + ": " + reason);
+            return {};
+        };
+
+        auto fileMagic = quint32{}, fileVersion = quint32{}, trailerMagic = quint32{};
+        auto indexOffset = quint64{};
+
+        auto header = QDataStream{ mapped.bytes(0, headerSize) };
+        header >> fileMagic >> fileVersion;
+
+        auto trailer = QDataStream{ mapped.bytes(mapped.size - trailerSize, trailerSize) };
+        trailer >> indexOffset >> trailerMagic;
+
+        if (fileMagic != ProjectFile::magic || trailerMagic != ProjectFile::magic)
+            return fail("not a project file");
+
+        if (fileVersion < firstVersion || fileVersion > ProjectFile::version)
+            return fail("unsupported version " + QString::number(fileVersion));
+
+        if (indexOffset < quint64(headerSize) || indexOffset > quint64(mapped.size - trailerSize))
+            return fail("index out of bounds");
+
+        auto stream = QDataStream{ mapped.bytes(qint64(indexOffset), mapped.size - trailerSize - qint64(indexOffset)) };
+        stream.setVersion(QDataStream::Qt_5_12);
+
+        auto index = Index{};
+        auto count = quint32{};
+        stream >> count >> index.current;
+
+        if (count == 0u || index.current >= count)
+            return fail("invalid history");
+
+        for (quint32 i = 0; i < count; ++i)
+        {
+            auto entry = readEntry(stream, mapped);
+            if (!entry)
+                return fail("invalid image entry");
+
+            index.history.push_back(std::move(*entry));
+        }
+
+        auto hasLayer = false;
+        stream >> hasLayer;
+        if (hasLayer)
+        {
+            auto layer = LayerState{};
+            auto kind = qint32{};
+            stream >> kind >> layer.sourcePosition >> layer.translate >> layer.rotate;
+
+            auto entry = readEntry(stream, mapped);
+            if (!entry || (kind != LayerState::COPY && kind != LayerState::CUT))
+                return fail("invalid layer");
+
+            layer.kind       = LayerState::Kind(kind);
+            index.layer      = std::move(layer);
+            index.layerEntry = std::move(*entry);
+        }
+
+        if (fileVersion > firstVersion)
+        {
+            index.thumbnail = readEntry(stream, mapped);
+            if (!index.thumbnail)
+                return fail("invalid thumbnail");
+        }
+
+        if (stream.status() != QDataStream::Ok)
+            return fail("truncated index");
+
+        return index;
+    }
+}
+
+auto ProjectFile::write(const QString& filepath, const std::vector<QImage>& history, unsigned int current,
+                        const std::optional<LayerState>& layer) -> bool
+{
+    if (history.empty() || current >= history.size())
+        return false;
+
+    // the previous file is only replaced once everything has been written successfully
+    auto file = QSaveFile{ filepath };
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        Logger::warning("Failed to open " + filepath + " for writing: " + file.errorString());
+        return false;
+    }
+
+    auto stream = QDataStream{ &file };
+    stream.setVersion(QDataStream::Qt_5_12);
+    stream << magic << version;
+
+    const auto writeImage = [&](const QImage& image) {
+        const auto img = image.convertToFormat(IDataAccess::imageFormat);
+        auto entry = ImageEntry{ img.width(), img.height(), {} };
+
+        for (const auto& tile : compressTiles(img))
+        {
+            entry.tiles.push_back({ quint64(file.pos()), quint32(tile.size()) });
+            stream.writeRawData(tile.constData(), tile.size());
+        }
+
+        return entry;
+    };
+
+    auto entries = std::vector<ImageEntry>{};
+    for (const auto& image : history)
+        entries.push_back(writeImage(image));
+
+    const auto layerEntry = layer ? std::make_optional(writeImage(layer->image)) : std::nullopt;
+
+    // so that previews of the file do not need to decode the whole current image
+    const auto& shown = history[current];
+    const auto thumbnailEntry = writeImage(shown.width() > thumbnailSize || shown.height() > thumbnailSize
+                                           ? shown.scaled(thumbnailSize, thumbnailSize, Qt::KeepAspectRatio, Qt::SmoothTransformation)
+                                           : shown);
+
+    // index
+    const auto indexOffset = quint64(file.pos());
+    stream << quint32(entries.size()) << quint32(current);
+    for (const auto& entry : entries)
+        writeEntry(stream, entry);
+
+    stream << layer.has_value();
+    if (layer)
+    {
+        stream << qint32(layer->kind) << layer->sourcePosition << layer->translate << layer->rotate;
+        writeEntry(stream, *layerEntry);
+    }
+
+    writeEntry(stream, thumbnailEntry);
+
+    // trailer
+    stream << indexOffset << magic;
+
+    if (stream.status() != QDataStream::Ok || !file.commit())
+    {
+        Logger::warning("Failed to write project file " + filepath + ": " + file.errorString());
+        return false;
+    }
+
+    return true;
+}
+
+auto ProjectFile::read(const QString& filepath) -> std::optional<Contents>
+{
+    const auto mapped = std::make_shared<MappedFile>(filepath);
+    const auto index = readIndex(*mapped, filepath);
+    if (!index)
+        return {};
+
+    const auto fail = [&filepath](const QString& reason) -> std::optional<Contents> {
+        Logger::warning("Invalid project file " + filepath + ": " + reason);
+        return {};
+    };
+
+    auto contents = Contents{};
+    contents.current = index->current;
+
+    if (index->layer)
+    {
+        contents.layer = index->layer;
+        contents.layer->image = decodeImage(*mapped, index->layerEntry);
+        if (contents.layer->image.isNull())
+            return fail("corrupt layer");
+    }
+
+    // only the current image is shown after opening, the others are decoded on undo and redo
+    for (quint32 i = 0; i < index->history.size(); ++i)
+    {
+        if (i == index->current)
+        {
+            auto image = decodeImage(*mapped, index->history[i]);
+            if (image.isNull())
+                return fail("corrupt image");
+
+            contents.history.emplace_back(std::move(image));
+        }
+        else
+        {
+            contents.history.emplace_back(std::function<QImage()>{ [mapped, entry = index->history[i]] {
+                return decodeImage(*mapped, entry);
+            }});
+        }
+    }
+
+    return contents;
+}
+
+auto ProjectFile::readThumbnail(const QString& filepath) -> QImage
+{
+    const auto mapped = MappedFile{ filepath };
+    const auto index = readIndex(mapped, filepath);
+    if (!index || !index->thumbnail)
+        return {};
+
+    return decodeImage(mapped, *index->thumbnail);
+}
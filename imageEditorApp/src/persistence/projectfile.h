@@ -0,0 +1,44 @@
+#pragma once
+
+#include <projectdata.h>
+#include <util.h>
+
+#include <optional>
+#include <vector>
+#include <QImage>
+#include <QString>
+
+// ProjectFile: Reads and writes the native project format of the editor.
+//              The file starts with a short header, followed by the pixels of every image of
+//              the history and of the pending layer, cut into tiles of tileSize x tileSize pixels,
+//              each compressed on its own. The index, which holds the history, the layer state,
+//              and the position of every tile, comes after the tiles, and the file is closed by
+//              a trailer that points to the index. Since the second version, the index also
+//              points to a thumbnail of the current image, which is stored like the other images.
+//              Reading maps the file into memory, and only decompresses the tiles of the current
+//              image and of the pending layer. The other images of the history are decoded
+//              straight from the mapping the first time they are needed.
+class ProjectFile
+{
+public:
+    static const QString suffix;
+    static const quint32 magic;
+    static const quint32 version;
+    static const int     tileSize;
+    static const int     compressionLevel;
+    static const int     thumbnailSize;
+
+    struct Contents
+    {
+        std::vector<util::lazy<QImage>> history;
+        unsigned int                    current{ 0u };
+        std::optional<LayerState>       layer;
+    };
+
+    static auto write(const QString& filepath, const std::vector<QImage>& history, unsigned int current,
+                      const std::optional<LayerState>& layer) -> bool;
+    static auto read(const QString& filepath) -> std::optional<Contents>;
+
+    // only decodes the thumbnail, in the row order of the history; null for files of the first version
+    static auto readThumbnail(const QString& filepath) -> QImage;
+};
@@ -0,0 +1,107 @@
+#include "thumbnailcache.h"
+#include "projectfile.h"
+#include <logger.h>
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+const int ThumbnailCache::thumbnailSize{ 128 };
+
+namespace
+{
+    // the keys of the freedesktop thumbnail spec
+    const QString uriKey{ "Thumb::URI" };
+    const QString mtimeKey{ "Thumb::MTime" };
+    const QString sizeKey{ "Thumb::Size" };
+}
+
+auto ThumbnailCache::thumbnail(const QString& filepath) const -> std::optional<QImage>
+{
+    if (auto cached = lookup(filepath))
+        return cached;
+
+    return generate(filepath);
+}
+
+auto ThumbnailCache::lookup(const QString& filepath) const -> std::optional<QImage>
+{
+    const auto info = QFileInfo{ filepath };
+    if (!info.exists())
+        return {};
+
+    const auto thumb = QImage{ cachePath(filepath) };
+    if (thumb.isNull())
+        return {};
+
+    if (thumb.text(uriKey) != info.absoluteFilePath() ||
+        thumb.text(mtimeKey) != QString::number(info.lastModified().toSecsSinceEpoch()) ||
+        thumb.text(sizeKey) != QString::number(info.size()))
+        return {};
+
+    return thumb;
+}
+
+auto ThumbnailCache::generate(const QString& filepath) const -> std::optional<QImage>
+{
+    const auto info = QFileInfo{ filepath };
+
+    auto thumb = decodeScaled(filepath);
+    if (thumb.isNull())
+        return {};
+
+    thumb.setText(uriKey, info.absoluteFilePath());
+    thumb.setText(mtimeKey, QString::number(info.lastModified().toSecsSinceEpoch()));
+    thumb.setText(sizeKey, QString::number(info.size()));
+
+    // a thumbnail which could not be stored is still good for this session
+    auto file = QSaveFile{ cachePath(filepath) };
+    if (!QDir{}.mkpath(directory) || !file.open(QIODevice::WriteOnly) || !thumb.save(&file, "PNG") || !file.commit())
+        Logger::warning("Failed to store the thumbnail of " + filepath);
+
+    return thumb;
+}
+
+auto ThumbnailCache::defaultDirectory() -> QString
+{
+    return QDir{ QStandardPaths::writableLocation(QStandardPaths::CacheLocation) }.filePath("thumbnails");
+}
+
+auto ThumbnailCache::cachePath(const QString& filepath) const -> QString
+{
+    const auto hash = QCryptographicHash::hash(QFileInfo{ filepath }.absoluteFilePath().toUtf8(), QCryptographicHash::Md5);
+    return QDir{ directory }.filePath(QString::fromLatin1(hash.toHex()) + ".png");
+}
+
+auto ThumbnailCache::decodeScaled(const QString& filepath) -> QImage
+{
+    auto image = QImage{};
+
+    // projects store a thumbnail of their current image, mirrored like the history
+    if (QFileInfo{ filepath }.suffix() == ProjectFile::suffix)
+    {
+        image = ProjectFile::readThumbnail(filepath).mirrored();
+    }
+    else
+    {
+        // the reader only decodes the pixels needed for the scaled size, if the format supports it
+        auto reader = QImageReader{ filepath };
+        const auto size = reader.size();
+        if (size.isValid() && (size.width() > thumbnailSize || size.height() > thumbnailSize))
+            reader.setScaledSize(size.scaled(thumbnailSize, thumbnailSize, Qt::KeepAspectRatio));
+
+        image = reader.read();
+    }
+
+    if (image.isNull())
+        return {};
+
+    // for formats that can not be scaled while decoding
+    if (image.width() > thumbnailSize || image.height() > thumbnailSize)
+        image = image.scaled(thumbnailSize, thumbnailSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+
+    return image;
+}
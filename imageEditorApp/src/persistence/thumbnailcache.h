@@ -0,0 +1,34 @@
+#pragma once
+
+#include <optional>
+#include <QImage>
+#include <QString>
+
+// ThumbnailCache: Small previews of image and project files, kept on disk between sessions.
+//                 Every thumbnail is a PNG, which records the path, modification time and size of
+//                 its source file (like the freedesktop thumbnail spec), and is regenerated when
+//                 they do not match anymore. Thumbnails are created from scaled decodes, so that
+//                 formats which support it (e.g. JPEG) never decode the full image, and projects
+//                 only decode the thumbnail they store.
+//                 The methods only work on files, so they are safe to call from any thread.
+class ThumbnailCache
+{
+public:
+    static const int thumbnailSize;
+
+    explicit ThumbnailCache(const QString& directory = defaultDirectory()) : directory{ directory } { }
+
+    // the cached thumbnail if it is still valid, otherwise a newly generated one
+    auto thumbnail(const QString& filepath) const -> std::optional<QImage>;
+    auto lookup(const QString& filepath) const -> std::optional<QImage>;
+    auto generate(const QString& filepath) const -> std::optional<QImage>;
+
+    static auto defaultDirectory() -> QString;
+
+private:
+    const QString directory;
+
+    auto cachePath(const QString& filepath) const -> QString;
+
+    static auto decodeScaled(const QString& filepath) -> QImage;
+};
@@ -0,0 +1,162 @@
+#include "framebufferreader.h"
+#include "openglexception.h"
+#include <util.h>
+
+#include <algorithm>
+#include <cstring>
+#include <QOpenGLContext>
+
+using namespace util::types;
+
+const int FramebufferReader::stripBytes{ 8 * 1024 * 1024 };
+const int FramebufferReader::maxTileSize{ 4096 };     // 64 MiB of framebuffer
+
+namespace
+{
+    const GLuint64 waitTimeout{ 1000000000u };    // in nanoseconds
+}
+
+FramebufferReader::FramebufferReader()
+    : buffers{ QOpenGLBuffer{ QOpenGLBuffer::PixelPackBuffer }, QOpenGLBuffer{ QOpenGLBuffer::PixelPackBuffer } }
+{
+    initializeOpenGLFunctions();
+
+    const auto context = QOpenGLContext::currentContext();
+    const auto format  = context->format();
+    hasSync = format.majorVersion() > 3 || (format.majorVersion() == 3 && format.minorVersion() >= 2) ||
+              context->hasExtension("GL_ARB_sync");
+
+    auto maxTextureSize = 0, maxRenderbufferSize = 0;
+    auto maxViewportDims = std::array<GLint, 2>{};
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+    glGetIntegerv(GL_MAX_RENDERBUFFER_SIZE, &maxRenderbufferSize);
+    glGetIntegerv(GL_MAX_VIEWPORT_DIMS, maxViewportDims.data());
+    tileSize = std::min({ maxTileSize, maxTextureSize, maxRenderbufferSize, maxViewportDims[0], maxViewportDims[1] });
+
+    for (auto& buffer : buffers)
+    {
+        if (!buffer.create())
+            throw OpenGLException{ "Failed to create pixel buffer! "
+                                   "(This OpenGL implementation does not support pixel buffer objects)" };
+
+        buffer.setUsagePattern(QOpenGLBuffer::StreamRead);
+    }
+}
+
+void FramebufferReader::bind(const QSize& size)
+{
+    if (!framebuffer || framebuffer->size() != size)
+        framebuffer = std::make_unique<QOpenGLFramebufferObject>(size, GL_TEXTURE_2D);
+
+    if (!framebuffer->bind())
+        throw OpenGLException{ "Failed to bind framebuffer!" };
+}
+
+void FramebufferReader::release()
+{
+    if (!framebuffer->release())
+        throw OpenGLException{ "Failed to release framebuffer!" };
+}
+
+void FramebufferReader::read(QImage& image, const QRect& target)
+{
+    const auto width        = target.width();
+    const auto height       = target.height();
+    const auto rowsPerStrip = std::max(1, stripBytes / (width * 4));
+
+    auto strips  = Strips{ *this };
+    auto nextRow = 0;
+
+    strips[0] = issue(buffers[0], nextRow, std::min(rowsPerStrip, height - nextRow), width);
+    nextRow  += strips[0].rows;
+
+    // the next strip is issued before waiting for the current one, so that its transfer into the other buffer
+    // overlaps with the wait and with copying the current one out
+    for (std::size_t i = 0; strips[i].rows > 0; i = 1u - i)
+    {
+        if (nextRow < height)
+        {
+            strips[1u - i] = issue(buffers[1u - i], nextRow, std::min(rowsPerStrip, height - nextRow), width);
+            nextRow       += strips[1u - i].rows;
+        }
+
+        collect(buffers[i], strips[i], image, target);
+        strips[i] = {};
+    }
+}
+
+// GL_BGRA with GL_UNSIGNED_INT_8_8_8_8_REV packs every pixel into a native 32 bit 0xAARRGGBB word, which is
+// QImage::Format_ARGB32 on hosts of either byte order; the rows arrive bottom up, like the editor keeps them
+auto FramebufferReader::issue(QOpenGLBuffer& buffer, int firstRow, int rows, int width) -> Strip
+{
+    // reallocating orphans the storage a previous read may still be mapped from
+    buffer.bind();
+    buffer.allocate(rows * width * 4);
+
+    // with a pixel pack buffer bound, the data pointer is an offset into the buffer, so this does not wait
+    glReadPixels(0, firstRow, width, rows, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, nullptr);
+
+    const auto fence = hasSync ? glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) : nullptr;
+    buffer.release();
+
+    return { firstRow, rows, fence };
+}
+
+// the fence is deleted once it has been waited for, so that the strips do not delete it again
+void FramebufferReader::collect(QOpenGLBuffer& buffer, Strip& strip, QImage& image, const QRect& target)
+{
+    // without fences, mapping the buffer waits for the transfer instead
+    if (strip.fence)
+    {
+        auto result = glClientWaitSync(strip.fence, GL_SYNC_FLUSH_COMMANDS_BIT, waitTimeout);
+        while (result == GL_TIMEOUT_EXPIRED)
+            result = glClientWaitSync(strip.fence, 0, waitTimeout);
+
+        glDeleteSync(strip.fence);
+        strip.fence = nullptr;
+
+        if (result == GL_WAIT_FAILED)
+            throw OpenGLException{ "Failed to wait for the framebuffer readback!" };
+    }
+
+    const auto mapped = MappedBuffer{ buffer };
+    if (!mapped.getData())
+        throw OpenGLException{ "Failed to map pixel buffer!" };
+
+    // the rows of the strip are contiguous in the image, unless the target is narrower than the image
+    const auto source   = mapped.getData();
+    const auto rowBytes = std::size_t(target.width() * 4);
+    const auto firstRow = target.top() + strip.firstRow;
+
+    if (target.left() == 0 && target.width() == image.width() && std::size_t(image.bytesPerLine()) == rowBytes)
+    {
+        std::memcpy(image.scanLine(firstRow), source, rowBytes * std::size_t(strip.rows));
+    }
+    else
+    {
+        for (int row = 0; row < strip.rows; ++row)
+            std::memcpy(image.scanLine(firstRow + row) + target.left() * 4, source + rowBytes * std::size_t(row), rowBytes);
+    }
+}
+
+FramebufferReader::Strips::~Strips()
+{
+    for (const auto& strip : strips)
+        if (strip.fence)
+            reader.glDeleteSync(strip.fence);
+}
+
+FramebufferReader::MappedBuffer::MappedBuffer(QOpenGLBuffer& buffer)
+    : buffer{ buffer }
+{
+    buffer.bind();
+    data = buffer.map(QOpenGLBuffer::ReadOnly);
+}
+
+FramebufferReader::MappedBuffer::~MappedBuffer()
+{
+    if (data)
+        buffer.unmap();
+
+    buffer.release();
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <QImage>
+#include <QOpenGLBuffer>
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLFramebufferObject>
+#include <QRect>
+#include <QSize>
+
+// FramebufferReader: Renders offscreen into a framebuffer that is kept between uses, and reads it back
+//                    through two pixel buffer objects. The rows are read in strips which alternate between
+//                    the two buffers, so that copying one strip out overlaps with the transfer of the next.
+//                    Every strip is copied straight into its rows of the result, which keeps the GL row order
+//                    the editor stores its images in. Images larger than the tile size are rendered and read
+//                    tile by tile, so the framebuffer never exceeds it. Every function expects the GL context
+//                    to be current.
+class FramebufferReader : protected QOpenGLExtraFunctions
+{
+public:
+    static const int stripBytes;
+    static const int maxTileSize;
+
+    FramebufferReader();
+
+    FramebufferReader(const FramebufferReader&) = delete;
+    FramebufferReader& operator=(const FramebufferReader&) = delete;
+
+    // the largest framebuffer bind accepts, maxTileSize or less if the implementation's limits are lower
+    auto getTileSize() const -> int { return tileSize; }
+
+    // binds a framebuffer of the given size, which is only recreated when the size changes
+    void bind(const QSize& size);
+    void release();
+
+    // reads back the lower left target.size() pixels of what has been drawn into the framebuffer
+    // since it was bound, into the target rect of the image; the pixels are written as they were
+    // drawn, as QImage::Format_ARGB32, so the image has to be in that format, and the bottom row
+    // of the framebuffer goes into the top row of the target
+    void read(QImage& image, const QRect& target);
+
+private:
+    struct Strip
+    {
+        int    firstRow{ 0 };
+        int    rows{ 0 };
+        GLsync fence{ nullptr };
+    };
+
+    // Strips: The strips in flight during a read, whose fences are deleted if it stops early, e.g. because
+    //         collect threw
+    class Strips
+    {
+    public:
+        explicit Strips(FramebufferReader& reader) : reader{ reader } { }
+        ~Strips();
+
+        Strips(const Strips&) = delete;
+        Strips& operator=(const Strips&) = delete;
+
+        auto operator[](std::size_t i) -> Strip& { return strips[i]; }
+
+    private:
+        FramebufferReader&   reader;
+        std::array<Strip, 2> strips;
+    };
+
+    // MappedBuffer: Maps a buffer for reading while it lives, and unmaps and releases it afterwards
+    class MappedBuffer
+    {
+    public:
+        explicit MappedBuffer(QOpenGLBuffer& buffer);
+        ~MappedBuffer();
+
+        MappedBuffer(const MappedBuffer&) = delete;
+        MappedBuffer& operator=(const MappedBuffer&) = delete;
+
+        auto getData() const -> const uchar* { return static_cast<const uchar*>(data); }
+
+    private:
+        QOpenGLBuffer& buffer;
+        void*          data;
+    };
+
+    std::unique_ptr<QOpenGLFramebufferObject> framebuffer{ nullptr };
+    std::array<QOpenGLBuffer, 2>              buffers;
+    bool                                      hasSync{ false };   // fences need GL 3.2 or ARB_sync
+    int                                       tileSize{ 0 };
+
+    auto issue(QOpenGLBuffer& buffer, int firstRow, int rows, int width) -> Strip;
+    void collect(QOpenGLBuffer& buffer, Strip& strip, QImage& image, const QRect& target);
+};
@@ -0,0 +1,49 @@
+#include "offscreencontext.h"
+#include <logger.h>
+
+#include <QGuiApplication>
+#include <QOpenGLFunctions>
+
+auto OffscreenContext::create() -> std::unique_ptr<OffscreenContext>
+{
+    // offscreen surfaces need the platform integration of a GUI application
+    if (!qobject_cast<QGuiApplication*>(QCoreApplication::instance()))
+        return nullptr;
+
+    auto offscreen = std::unique_ptr<OffscreenContext>{ new OffscreenContext };
+    if (!offscreen->init())
+        return nullptr;
+
+    return offscreen;
+}
+
+OffscreenContext::~OffscreenContext()
+{
+    if (context && QOpenGLContext::currentContext() == context.get())
+        context->doneCurrent();
+}
+
+auto OffscreenContext::init() -> bool
+{
+    context = std::make_unique<QOpenGLContext>();
+    if (!context->create())
+    {
+        Logger::warning("Failed to create an offscreen OpenGL context");
+        return false;
+    }
+
+    surface = std::make_unique<QOffscreenSurface>();
+    surface->setFormat(context->format());
+    surface->create();
+
+    if (!context->makeCurrent(surface.get()))
+    {
+        Logger::warning("Failed to make the offscreen OpenGL context current");
+        return false;
+    }
+
+    Logger::debug("Created an offscreen OpenGL context, renderer: " +
+                  QString{ reinterpret_cast<const char*>(context->functions()->glGetString(GL_RENDERER)) });
+
+    return true;
+}
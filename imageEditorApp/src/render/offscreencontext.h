@@ -0,0 +1,31 @@
+#pragma once
+
+#include <memory>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+
+// OffscreenContext: An OpenGL context on an offscreen surface, which stays current for the lifetime of the
+//                   object, so that a Renderer can draw without a window, e.g. in tests and benchmarks.
+//                   It needs a GUI application; on a machine without a display run it on the "offscreen"
+//                   platform with a software GL implementation, e.g. Mesa's llvmpipe.
+class OffscreenContext
+{
+public:
+    // returns null if there is no GUI application, or no OpenGL context could be created and made current
+    static auto create() -> std::unique_ptr<OffscreenContext>;
+
+    ~OffscreenContext();
+
+    OffscreenContext(const OffscreenContext&) = delete;
+    OffscreenContext& operator=(const OffscreenContext&) = delete;
+
+    auto getContext() -> QOpenGLContext& { return *context; }
+
+private:
+    std::unique_ptr<QOpenGLContext>    context{ nullptr };
+    std::unique_ptr<QOffscreenSurface> surface{ nullptr };
+
+    OffscreenContext() = default;
+
+    auto init() -> bool;
+};
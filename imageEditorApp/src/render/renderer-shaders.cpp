@@ -0,0 +1,169 @@
+#include "renderer.h"
+
+const char* const Renderer::vertexShaderSource =
+R"END(
+#version 120
+
+attribute vec2 in_Position;
+attribute vec2 in_TexCoords;
+varying   vec2 out_TexCoords;
+
+uniform   mat4 matrix;
+uniform   vec4 texRect;     // the part of the texture that the quad shows, the offset in xy and the scale in zw
+
+void main(void)
+{
+    gl_Position = matrix * vec4(in_Position, 0.0, 1.0);
+    out_TexCoords = texRect.xy + in_TexCoords * texRect.zw;
+};
+)END";
+
+// the version and the defines of the stages a variant applies are put in front of it by Renderer::colorShader,
+// without any of them the pixels are passed through
+const char* const Renderer::fragmentShaderSource =
+R"END(
+varying vec2 out_TexCoords;
+
+uniform sampler2D texture;
+uniform vec4      erased;           // left, top, right and bottom in texture coordinates, empty when nothing is erased
+
+// the tone curves are precomputed by ToneCurves whenever the color data changes
+uniform sampler1D channelCurves;    // red, green and blue curves, one entry for each 8-bit value, filtered linearly
+uniform sampler1D contrastCurve;    // finer, and filtered linearly as well
+uniform float     brightLevel;
+
+vec4 toYCbCr(vec4 rgba)
+{
+    float r = rgba.x, g = rgba.y, b = rgba.z;
+    
+    float y  = clamp( (( 0.299f  * r) + (0.587f  * g) + (0.114f  * b))                  , 0.0f, 1.0f );
+    float cb = clamp( ((-0.1687f * r) - (0.3313f * g) + (0.5f    * b) + (128.0f/255.0f)), 0.0f, 1.0f );
+    float cr = clamp( (( 0.5f    * r) - (0.4187f * g) - (0.0813f * b) + (128.0f/255.0f)), 0.0f, 1.0f );
+
+    return vec4(y, cb, cr, rgba.w);
+}
+    
+vec4 toRGB(vec4 ycbcr)
+{
+    float y = ycbcr.x, cb = ycbcr.y, cr = ycbcr.z;
+    
+    float r = clamp( (y                                      + (1.402f  * (cr - (128.0f/255.0f)))), 0.0f, 1.0f );
+    float g = clamp( (y - (0.3441f * (cb - (128.0f/255.0f))) - (0.7141f * (cr - (128.0f/255.0f)))), 0.0f, 1.0f );
+    float b = clamp( (y + (1.722f  * (cb - (128.0f/255.0f))))                                     , 0.0f, 1.0f );
+
+    return vec4(r, g, b, ycbcr.w);
+}
+
+// both curves are sampled at the centers of their entries, so 0 and 1 hit the first and last one exactly
+vec3 applyChannels(vec3 rgb)
+{
+    vec3 coords = (rgb * 255.0f + 0.5f) / 256.0f;
+    return vec3(texture1D(channelCurves, coords.x).x,
+                texture1D(channelCurves, coords.y).y,
+                texture1D(channelCurves, coords.z).z);
+}
+
+float contrast(float ch)
+{
+    return texture1D(contrastCurve, (ch * 4095.0f + 0.5f) / 4096.0f).x;
+}
+
+// the erased area of a cut is not in the texture, it is drawn over with the color the image gets when merged
+vec4 fetch(vec2 coords)
+{
+    if (all(greaterThanEqual(coords, erased.xy)) && all(lessThan(coords, erased.zw)))
+        return vec4(0.0, 0.0, 0.0, 1.0);
+
+    return texture2D(texture, coords);
+}
+
+vec4 IO(vec4 pix)
+{
+#if defined(COLOR_CHANNELS) || defined(COLOR_CONTRAST) || defined(COLOR_BRIGHTNESS)
+    // apply color operations on the pixel
+#  ifdef COLOR_CHANNELS
+    pix.xyz = applyChannels(pix.xyz);
+#  endif
+
+    // apply intensity operations on the pixel, the round trip to YCbCr is kept like in ColorEngine
+    vec4 ycbcr = toYCbCr(pix);
+#  ifdef COLOR_CONTRAST
+    ycbcr.xyz = vec3(contrast(ycbcr.x), contrast(ycbcr.y), contrast(ycbcr.z));
+#  endif
+#  ifdef COLOR_BRIGHTNESS
+    ycbcr.x += brightLevel;
+#  endif
+
+    return toRGB(ycbcr);
+#else
+    return pix;
+#endif
+}
+
+void main(void)
+{
+    gl_FragColor = IO(fetch(out_TexCoords.st));
+};
+)END";
+
+const char* const Renderer::grayscaleFragmentShaderSource =
+R"END(
+#version 120
+
+varying vec2 out_TexCoords;
+
+uniform sampler2D texture;
+uniform vec4      erased;           // like in the color shader
+
+vec4 toYCbCr(vec4 rgba)
+{
+    float r = rgba.x, g = rgba.y, b = rgba.z;
+    
+    float y  = clamp( (( 0.299f  * r) + (0.587f  * g) + (0.114f  * b))                  , 0.0f, 1.0f );
+    float cb = clamp( ((-0.1687f * r) - (0.3313f * g) + (0.5f    * b) + (128.0f/255.0f)), 0.0f, 1.0f );
+    float cr = clamp( (( 0.5f    * r) - (0.4187f * g) - (0.0813f * b) + (128.0f/255.0f)), 0.0f, 1.0f );
+
+    return vec4(y, cb, cr, rgba.w);
+}
+
+vec4 fetch(vec2 coords)
+{
+    if (all(greaterThanEqual(coords, erased.xy)) && all(lessThan(coords, erased.zw)))
+        return vec4(0.0, 0.0, 0.0, 1.0);
+
+    return texture2D(texture, coords);
+}
+
+vec4 grayscale(vec4 rgba)
+{
+    float y = toYCbCr(rgba).x;
+    return vec4(y, y, y, rgba.w);
+}
+
+void main(void)
+{
+    gl_FragColor = grayscale(fetch(out_TexCoords.st));
+};
+)END";
+// the frame around the image: the fragments within borderWidth image pixels of the quad's edges get the color,
+// the ones inside are discarded, so the frame costs neither a texture nor an upload
+const char* const Renderer::frameFragmentShaderSource =
+R"END(
+#version 120
+
+varying vec2 out_TexCoords;
+
+uniform vec2  imageSize;
+uniform float borderWidth;
+uniform vec4  borderColor;
+
+void main(void)
+{
+    vec2 pixel = out_TexCoords * imageSize;
+
+    if (all(greaterThanEqual(pixel, vec2(borderWidth))) && all(lessThan(pixel, imageSize - borderWidth)))
+        discard;
+
+    gl_FragColor = borderColor;
+};
+)END";
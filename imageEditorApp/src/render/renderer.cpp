@@ -0,0 +1,302 @@
+#include "renderer.h"
+#include <logger.h>
+#include "openglexception.h"
+#include <tonecurves.h>
+#include <util.h>
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QOpenGLFramebufferObject>
+
+using namespace util::types;
+
+const int  Renderer::vertexAttribLoc{ 0 };
+const int  Renderer::texcoordAttribLoc{ 1 };
+const uint Renderer::channelCurvesUnit{ 1 };
+const uint Renderer::contrastCurveUnit{ 2 };
+const QRectF Renderer::wholeTexture{ 0.0, 0.0, 1.0, 1.0 };
+const QRgb   Renderer::frameColor{ qRgba(0x80, 0x80, 0x80, 0x00) };
+const float  Renderer::frameWidth{ 4.0f };                            // in image pixels
+
+namespace
+{
+    // 16 bits per entry, since the curves are applied before the conversion to YCbCr and back
+    auto makeCurveTexture(int size, QOpenGLTexture::Filter filter) -> std::unique_ptr<QOpenGLTexture>
+    {
+        auto texture = std::make_unique<QOpenGLTexture>(QOpenGLTexture::Target1D);
+
+        texture->setFormat(QOpenGLTexture::RGBA16_UNorm);
+        texture->setSize(size);
+        texture->setMagnificationFilter(filter);
+        texture->setMinificationFilter(filter);
+        texture->setWrapMode(QOpenGLTexture::ClampToEdge);
+        texture->allocateStorage(QOpenGLTexture::RGBA, QOpenGLTexture::UInt16);
+
+        return texture;
+    }
+
+    // the bits of a color shader variant, which stages of the color operations it applies
+    const std::size_t channelsStage{ 1u };
+    const std::size_t contrastStage{ 2u };
+    const std::size_t brightStage{ 4u };
+
+    // the stages at their default values leave the pixels unchanged
+    auto colorStages(const ColorData& data) -> std::size_t
+    {
+        const auto def = ColorData{};
+        const auto channels = data.red != def.red || data.green != def.green || data.blue != def.blue;
+
+        return (channels ? channelsStage : 0u) | (data.contrast != def.contrast ? contrastStage : 0u) |
+               (data.bright != def.bright ? brightStage : 0u);
+    }
+
+    auto toUNorm16(float value) -> quint16
+    {
+        return static_cast<quint16>(util::round(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+    }
+
+    // the curves go into the red, green and blue channels of the texels, the missing ones are zero
+    auto toCurveData(const std::vector<float>& red, const std::vector<float>& green = {},
+                     const std::vector<float>& blue = {}) -> std::vector<quint16>
+    {
+        auto data = std::vector<quint16>(red.size() * 4u, 0u);
+        for (std::size_t i = 0; i < red.size(); ++i)
+        {
+            data[4u * i]      = toUNorm16(red[i]);
+            data[4u * i + 1u] = green.empty() ? 0u : toUNorm16(green[i]);
+            data[4u * i + 2u] = blue.empty() ? 0u : toUNorm16(blue[i]);
+            data[4u * i + 3u] = 0xffffu;
+        }
+
+        return data;
+    }
+}
+
+Renderer::Renderer(int maxTileSize)
+{
+    initializeOpenGLFunctions();
+
+    tileSize = maxTileSize > 0 ? std::min(maxTileSize, reader.getTileSize()) : reader.getTileSize();
+
+    auto timer = QElapsedTimer{};
+    timer.start();
+
+    // the other variants are built when the color data first needs them
+    colorShader(ColorData{});
+
+    grayShaderProgram = makeShader(vertexShaderSource, grayscaleFragmentShaderSource);
+    frameShaderProgram = makeShader(vertexShaderSource, frameFragmentShaderSource);
+
+    // a filtered texture gives values between the 8-bit ones, the channel curves are interpolated for those too
+    channelCurves = makeCurveTexture(ToneCurves::channelSize, QOpenGLTexture::Linear);
+    contrastCurve = makeCurveTexture(ToneCurves::contrastSize, QOpenGLTexture::Linear);
+
+    const auto cached = !QCoreApplication::testAttribute(Qt::AA_DisableShaderDiskCache);
+    Logger::debug("Built the shader programs in " + QString::number(toDouble(timer.nsecsElapsed()) / 1e6, 'f', 2) +
+                  " ms, with the shader disk cache " + (cached ? "enabled" : "disabled"));
+}
+
+// the shader state that is the same for every quad, set once per frame
+void Renderer::begin(const ColorData& data, bool grayscale)
+{
+    selectedShader = grayscale ? grayShaderProgram.get() : &colorShader(data);
+
+    if (!renderState.use(*selectedShader))
+        throw OpenGLException{ "Failed to bind shader program!" };
+
+    if (grayscale)
+        return;
+
+    const auto stages = colorStages(data);
+    if (stages & (channelsStage | contrastStage))
+    {
+        updateToneCurves(data);
+
+        // the quad's own texture stays on unit 0
+        channelCurves->bind(channelCurvesUnit, QOpenGLTexture::ResetTextureUnit);
+        contrastCurve->bind(contrastCurveUnit, QOpenGLTexture::ResetTextureUnit);
+    }
+
+    if (stages & brightStage)
+        renderState.setUniform("brightLevel", data.bright);
+}
+
+// the texture parameters are set when the textures are created
+void Renderer::draw(const QMatrix4x4& matrix, const QRectF& erased, const QRectF& source)
+{
+    if (!selectedShader)
+        throw OpenGLException{ "Tried to draw before a shader program was selected!" };
+
+    // a frame may have been drawn in between, otherwise the program is still bound
+    if (!renderState.use(*selectedShader))
+        throw OpenGLException{ "Failed to bind shader program!" };
+
+    renderState.setUniform("matrix", matrix);
+    renderState.setUniform("erased", QVector4D{ toFloat(erased.left()), toFloat(erased.top()),
+                                                toFloat(erased.right()), toFloat(erased.bottom()) });
+    setSource(source);
+    setAttributes(*selectedShader);
+
+    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+}
+
+void Renderer::drawFrame(const QMatrix4x4& matrix, const QSize& size, QRgb color, float width)
+{
+    if (!renderState.use(*frameShaderProgram))
+        throw OpenGLException{ "Failed to bind shader program!" };
+
+    renderState.setUniform("matrix", matrix);
+    renderState.setUniform("imageSize", QVector2D{ toFloat(size.width()), toFloat(size.height()) });
+    renderState.setUniform("borderWidth", width);
+    renderState.setUniform("borderColor", QVector4D{ toFloat(qRed(color)) / 255.0f, toFloat(qGreen(color)) / 255.0f,
+                                                     toFloat(qBlue(color)) / 255.0f, toFloat(qAlpha(color)) / 255.0f });
+    setSource(wholeTexture);
+    setAttributes(*frameShaderProgram);
+
+    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+}
+
+auto Renderer::render(const QSize& size, const ColorData& data, bool grayscale, const DrawQuads& drawQuads) -> QImage
+{
+    const auto width  = size.width();
+    const auto height = size.height();
+
+    // the tiles share one framebuffer, the ones on the right and top edges only use a part of it
+    reader.bind({ std::min(width, tileSize), std::min(height, tileSize) });
+    renderState.invalidate();
+    begin(data, grayscale);
+
+    auto img = QImage{ size, QImage::Format_ARGB32 };
+    readbackTime = 0.0;
+
+    for (int y = 0; y < height; y += tileSize)
+    {
+        for (int x = 0; x < width; x += tileSize)
+        {
+            const auto tile = QRect{ x, y, std::min(tileSize, width - x), std::min(tileSize, height - y) };
+            glViewport(0, 0, tile.width(), tile.height());
+
+            // the framebuffer still holds the previous tile where the quads leave gaps
+            glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+
+            drawQuads(tileMatrix(tile, size));
+
+            auto timer = QElapsedTimer{};
+            timer.start();
+            reader.read(img, tile);
+            readbackTime += toDouble(timer.nsecsElapsed()) / 1e6;
+        }
+    }
+
+    reader.release();
+
+    if (!QOpenGLFramebufferObject::bindDefault())
+        throw OpenGLException{ "Failed to rebind default framebuffer!" };
+
+    return img;
+}
+
+auto Renderer::tileMatrix(const QRect& tile, const QSize& size) -> QMatrix4x4
+{
+    const auto sx = toFloat(size.width()) / toFloat(tile.width());
+    const auto sy = toFloat(size.height()) / toFloat(tile.height());
+
+    auto matrix = QMatrix4x4{};
+    matrix.translate(toFloat(size.width() - 2 * tile.left() - tile.width()) / toFloat(tile.width()),
+                     toFloat(size.height() - 2 * tile.top() - tile.height()) / toFloat(tile.height()));
+    matrix.scale(sx, sy);
+
+    return matrix;
+}
+
+auto Renderer::makeShader(const char* vShaderSrc, const char* fShaderSrc) -> std::unique_ptr<QOpenGLShaderProgram>
+{
+    assert(vShaderSrc && "vShaderSrc must not be null!");
+    assert(fShaderSrc && "fShaderSrc must not be null!");
+
+    auto shader = std::make_unique<QOpenGLShaderProgram>();
+
+    // the linked program is cached on disk, keyed by the driver and the sources,
+    // the sources are only compiled if there is no valid binary for them
+    if (!shader->addCacheableShaderFromSourceCode(QOpenGLShader::Vertex, vShaderSrc))
+        throw OpenGLException{ "Failed to add vertex shader, error: " + shader->log() };
+
+    if (!shader->addCacheableShaderFromSourceCode(QOpenGLShader::Fragment, fShaderSrc))
+        throw OpenGLException{ "Failed to add fragment shader, error: " + shader->log() };
+
+    shader->bindAttributeLocation("in_Position", vertexAttribLoc);
+    shader->bindAttributeLocation("in_TexCoords", texcoordAttribLoc);
+
+    if (!shader->link())
+        throw OpenGLException{ "Failed to link shader program!" };
+
+    if (!shader->bind())
+        throw OpenGLException{ "Failed to bind shader program!" };
+
+    return shader;
+}
+
+// the layout of VertexBuffer, the attributes are read from the bound buffer
+void Renderer::setAttributes(QOpenGLShaderProgram& shader)
+{
+    shader.enableAttributeArray(vertexAttribLoc);
+    shader.enableAttributeArray(texcoordAttribLoc);
+    shader.setAttributeBuffer(vertexAttribLoc, GL_FLOAT, 0, 2, 4 * sizeof(GLfloat));
+    shader.setAttributeBuffer(texcoordAttribLoc, GL_FLOAT, 2 * sizeof(GLfloat), 2, 4 * sizeof(GLfloat));
+}
+
+// the uniform of the program in use, which is only sent when it changes
+void Renderer::setSource(const QRectF& source)
+{
+    renderState.setUniform("texRect", QVector4D{ toFloat(source.x()), toFloat(source.y()),
+                                                 toFloat(source.width()), toFloat(source.height()) });
+}
+
+// the variant that only applies the stages which are not at their default values,
+// with the sliders at their defaults it only fetches the texture
+auto Renderer::colorShader(const ColorData& data) -> QOpenGLShaderProgram&
+{
+    const auto stages = colorStages(data);
+    auto& shader = colorShaders[stages];
+
+    if (!shader)
+    {
+        auto source = QByteArray{ "#version 120\n" };
+        if (stages & channelsStage) source += "#define COLOR_CHANNELS\n";
+        if (stages & contrastStage) source += "#define COLOR_CONTRAST\n";
+        if (stages & brightStage)   source += "#define COLOR_BRIGHTNESS\n";
+        source += fragmentShaderSource;
+
+        shader = makeShader(vertexShaderSource, source.constData());
+        shader->setUniformValue("channelCurves", toInt(channelCurvesUnit));
+        shader->setUniformValue("contrastCurve", toInt(contrastCurveUnit));
+
+        // makeShader leaves the new program bound
+        renderState.invalidate();
+
+        Logger::debug("Built the color shader variant " + QString::number(stages));
+    }
+
+    return *shader;
+}
+
+// the curves are only sampled again when a slider has changed, not for every quad and frame
+void Renderer::updateToneCurves(const ColorData& data)
+{
+    if (curvesData == data)
+        return;
+
+    const auto curves = ToneCurves{ data };
+
+    const auto channels = toCurveData(curves.getRed(), curves.getGreen(), curves.getBlue());
+    channelCurves->setData(QOpenGLTexture::RGBA, QOpenGLTexture::UInt16, channels.data());
+
+    const auto contrast = toCurveData(curves.getContrast());
+    contrastCurve->setData(QOpenGLTexture::RGBA, QOpenGLTexture::UInt16, contrast.data());
+
+    curvesData = data;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <colordata.h>
+#include "framebufferreader.h"
+#include "renderstate.h"
+
+#include <array>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <QImage>
+#include <QMatrix4x4>
+#include <QOpenGLFunctions>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLTexture>
+#include <QRect>
+#include <QRectF>
+#include <QSize>
+
+// Renderer: Draws textured quads through the color or grayscale shaders, and the frame around the image,
+//           onto whatever framebuffer is bound, or offscreen into an image. It owns the shader variants and
+//           the tone curve textures, and knows nothing of layers or widgets, so the same drawing runs in the
+//           display and in an OffscreenContext.
+//           Every function expects the GL context it was created in to be current.
+class Renderer : protected QOpenGLFunctions
+{
+public:
+    static const int  vertexAttribLoc;
+    static const int  texcoordAttribLoc;
+    static const uint channelCurvesUnit;
+    static const uint contrastCurveUnit;
+    static const QRectF wholeTexture;
+    static const QRgb   frameColor;
+    static const float  frameWidth;
+
+    // draws every quad of an image, with the matrix that maps the whole image onto the viewport
+    using DrawQuads = std::function<void(const QMatrix4x4&)>;
+
+    // a tile size of zero uses the largest one the implementation supports
+    explicit Renderer(int maxTileSize = 0);
+
+    Renderer(const Renderer&) = delete;
+    Renderer& operator=(const Renderer&) = delete;
+
+    // to be called whenever a program may have been bound behind the renderer's back, e.g. by a QPainter
+    void invalidate() { renderState.invalidate(); }
+
+    // binds the shader for the color data, and sets the state that is the same for every quad
+    void begin(const ColorData& data, bool grayscale);
+
+    // draws the bound vertex buffer with the bound texture, see VertexBuffer for the layout; the texture
+    // coordinates are mapped into source, e.g. a tile of an atlas, and the fragments whose mapped ones are
+    // within erased are drawn as opaque black, before the color operations
+    void draw(const QMatrix4x4& matrix, const QRectF& erased = {}, const QRectF& source = wholeTexture);
+
+    // draws the outermost width pixels of the bound vertex buffer, as if it were an image of the given size,
+    // in a solid color that the color operations do not touch; no texture is needed
+    void drawFrame(const QMatrix4x4& matrix, const QSize& size, QRgb color, float width);
+
+    // draws an image of the given size into the reader's framebuffer tile by tile, and reads it back,
+    // the rows of the result are in GL order; the default framebuffer is bound afterwards
+    auto render(const QSize& size, const ColorData& data, bool grayscale, const DrawQuads& drawQuads) -> QImage;
+
+    auto getTileSize() const -> int           { return tileSize; }
+    auto getReadbackTime() const -> double    { return readbackTime; }     // of the last render, in ms
+    auto takeUniformUpdates() -> int          { return renderState.takeUniformUpdates(); }
+
+    // maps the quads, which cover the whole viewport without a transformation, so that only the tile is in it
+    static auto tileMatrix(const QRect& tile, const QSize& size) -> QMatrix4x4;
+
+private:
+    static const char* const vertexShaderSource;
+    static const char* const fragmentShaderSource;
+    static const char* const grayscaleFragmentShaderSource;
+    static const char* const frameFragmentShaderSource;
+
+    std::array<std::unique_ptr<QOpenGLShaderProgram>, 8> colorShaders;    // indexed by the stages they apply
+    std::unique_ptr<QOpenGLShaderProgram> grayShaderProgram{ nullptr };
+    std::unique_ptr<QOpenGLShaderProgram> frameShaderProgram{ nullptr };
+    QOpenGLShaderProgram*                 selectedShader{ nullptr };
+    std::unique_ptr<QOpenGLTexture>       channelCurves{ nullptr };
+    std::unique_ptr<QOpenGLTexture>       contrastCurve{ nullptr };
+    std::optional<ColorData>              curvesData;
+    FramebufferReader                     reader;
+    RenderState                           renderState;
+    int                                   tileSize{ 0 };
+    double                                readbackTime{ 0.0 };
+
+    auto makeShader(const char* vShaderSrc, const char* fShaderSrc) -> std::unique_ptr<QOpenGLShaderProgram>;
+    auto colorShader(const ColorData& data) -> QOpenGLShaderProgram&;
+    void setAttributes(QOpenGLShaderProgram& shader);
+    void setSource(const QRectF& source);
+    void updateToneCurves(const ColorData& data);
+};
@@ -0,0 +1,100 @@
+#include "renderstate.h"
+#include "openglexception.h"
+
+void RenderState::forget(const QOpenGLShaderProgram& program)
+{
+    programs.erase(&program);
+
+    if (bound == &program)
+        bound = nullptr;
+}
+
+auto RenderState::use(QOpenGLShaderProgram& program) -> bool
+{
+    if (bound == &program)
+        return true;
+
+    if (!program.bind())
+        return false;
+
+    bound = &program;
+    return true;
+}
+
+void RenderState::setUniform(const char* name, float value)
+{
+    const auto loc = location(name);
+    auto& floats = programs[bound].floats;
+
+    const auto it = floats.find(loc);
+    if (it != floats.end() && it->second == value)
+        return;
+
+    floats[loc] = value;
+    bound->setUniformValue(loc, value);
+    ++uniformUpdates;
+}
+
+void RenderState::setUniform(const char* name, const QMatrix4x4& value)
+{
+    const auto loc = location(name);
+    auto& matrices = programs[bound].matrices;
+
+    const auto it = matrices.find(loc);
+    if (it != matrices.end() && it->second == value)
+        return;
+
+    matrices[loc] = value;
+    bound->setUniformValue(loc, value);
+    ++uniformUpdates;
+}
+
+void RenderState::setUniform(const char* name, const QVector2D& value)
+{
+    const auto loc = location(name);
+    auto& vectors = programs[bound].vectors2;
+
+    const auto it = vectors.find(loc);
+    if (it != vectors.end() && it->second == value)
+        return;
+
+    vectors[loc] = value;
+    bound->setUniformValue(loc, value);
+    ++uniformUpdates;
+}
+
+void RenderState::setUniform(const char* name, const QVector4D& value)
+{
+    const auto loc = location(name);
+    auto& vectors = programs[bound].vectors4;
+
+    const auto it = vectors.find(loc);
+    if (it != vectors.end() && it->second == value)
+        return;
+
+    vectors[loc] = value;
+    bound->setUniformValue(loc, value);
+    ++uniformUpdates;
+}
+
+auto RenderState::takeUniformUpdates() -> int
+{
+    const auto updates = uniformUpdates;
+    uniformUpdates = 0;
+
+    return updates;
+}
+
+auto RenderState::location(const char* name) -> int
+{
+    if (!bound)
+        throw OpenGLException{ QString{ "Tried to set uniform " } + name + " without a bound shader program!" };
+
+    auto& locations = programs[bound].locations;
+
+    const auto it = locations.find(name);
+    if (it != locations.end())
+        return it->second;
+
+    return locations[name] = bound->uniformLocation(name);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <QMatrix4x4>
+#include <QOpenGLShaderProgram>
+#include <QVector2D>
+#include <QVector4D>
+
+// RenderState: Remembers which shader program is bound and the uniform values each program was last sent,
+//              so that drawing a frame only sends what changed since the previous one. Uniform values are
+//              part of a program's state and survive binding another one, but the bound program is forgotten
+//              at the start of every frame. The uniform locations are looked up once per program and name.
+class RenderState
+{
+public:
+    // to be called at the start of every frame, and whenever a program was bound behind its back
+    void invalidate() { bound = nullptr; }
+
+    // must be called before a program is destroyed, since a new one may get its address
+    void forget(const QOpenGLShaderProgram& program);
+
+    // binds program unless it is bound already, returns false if it could not be bound
+    auto use(QOpenGLShaderProgram& program) -> bool;
+
+    // set the uniforms of the bound program, if their values changed
+    void setUniform(const char* name, float value);
+    void setUniform(const char* name, const QMatrix4x4& value);
+    void setUniform(const char* name, const QVector2D& value);
+    void setUniform(const char* name, const QVector4D& value);
+
+    // the number of uniform values actually sent since the last call
+    auto takeUniformUpdates() -> int;
+
+private:
+    struct ProgramState
+    {
+        std::unordered_map<std::string, int> locations;
+        std::unordered_map<int, float>       floats;
+        std::unordered_map<int, QMatrix4x4>  matrices;
+        std::unordered_map<int, QVector2D>   vectors2;
+        std::unordered_map<int, QVector4D>   vectors4;
+    };
+
+    std::unordered_map<const QOpenGLShaderProgram*, ProgramState> programs;
+    QOpenGLShaderProgram*                                         bound{ nullptr };
+    int                                                           uniformUpdates{ 0 };
+
+    auto location(const char* name) -> int;
+};
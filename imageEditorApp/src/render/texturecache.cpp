@@ -0,0 +1,68 @@
+#include "texturecache.h"
+#include <logger.h>
+
+void TextureCache::insert(qint64 key, util::owner_ptr<QOpenGLTexture> texture, qint64 bytes)
+{
+    if (!texture)
+        return;
+
+    const auto it = index.find(key);
+    if (it != index.end())
+        release(remove(it->second));
+
+    if (bytes > budget)
+    {
+        release(std::move(texture));
+        return;
+    }
+
+    entries.push_front(Entry{ key, std::move(texture), bytes });
+    index[key] = entries.begin();
+    this->bytes += bytes;
+
+    while (this->bytes > budget)
+    {
+        Logger::debug("Evicted a texture of " + QString::number(entries.back().bytes / 1024) + " KiB from the cache");
+        release(remove(std::prev(entries.end())));
+    }
+}
+
+auto TextureCache::take(qint64 key) -> util::owner_ptr<QOpenGLTexture>
+{
+    const auto it = index.find(key);
+    if (it == index.end())
+    {
+        ++counters.misses;
+        return nullptr;
+    }
+
+    ++counters.hits;
+    return remove(it->second);
+}
+
+void TextureCache::clear()
+{
+    while (!entries.empty())
+        release(remove(entries.begin()));
+}
+
+auto TextureCache::stats() const -> CacheStats
+{
+    auto stats = counters;
+    stats.images = entries.size();
+    stats.bytes  = static_cast<std::size_t>(bytes);
+    stats.budget = static_cast<std::size_t>(budget);
+
+    return stats;
+}
+
+auto TextureCache::remove(Entries::iterator it) -> util::owner_ptr<QOpenGLTexture>
+{
+    auto texture = std::move(it->texture);
+
+    bytes -= it->bytes;
+    index.erase(it->key);
+    entries.erase(it);
+
+    return texture;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cachestats.h>
+#include <util.h>
+
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <QOpenGLTexture>
+
+// TextureCache: Keeps the textures of images that are not on screen anymore, up to a budget of texture memory,
+//               so that showing one of those images again only swaps textures instead of uploading them.
+//               The textures are keyed by the QImage::cacheKey of the image they hold, which every copy of a
+//               history entry shares, and the least recently used ones are evicted first. A texture belongs
+//               to the cache until it is taken out again; evicted ones are handed to the release function,
+//               so that they are deleted in their GL context.
+class TextureCache
+{
+public:
+    using Release = std::function<void(util::owner_ptr<QOpenGLTexture>)>;
+
+    explicit TextureCache(qint64 budget, Release release) : budget{ budget }, release{ std::move(release) } { }
+    ~TextureCache() { clear(); }
+
+    TextureCache(const TextureCache&) = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+
+    // replaces the texture of the same key, one that is larger than the whole budget is released right away
+    void insert(qint64 key, util::owner_ptr<QOpenGLTexture> texture, qint64 bytes);
+
+    // removes the texture from the cache, returns a null one if there is none for the key
+    auto take(qint64 key) -> util::owner_ptr<QOpenGLTexture>;
+
+    void clear();
+
+    auto stats() const -> CacheStats;
+
+private:
+    struct Entry
+    {
+        qint64                          key;
+        util::owner_ptr<QOpenGLTexture> texture;
+        qint64                          bytes;
+    };
+
+    using Entries = std::list<Entry>;
+
+    const qint64  budget;
+    const Release release;
+
+    Entries                                       entries;    // the most recently used first
+    std::unordered_map<qint64, Entries::iterator> index;
+    qint64                                        bytes{ 0 };
+    CacheStats                                    counters;
+
+    auto remove(Entries::iterator it) -> util::owner_ptr<QOpenGLTexture>;
+};
@@ -0,0 +1,119 @@
+#include "tilepyramid.h"
+#include <idataaccess.h>
+#include <logger.h>
+#include <util.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <QElapsedTimer>
+
+using namespace util::types;
+
+TilePyramid::TilePyramid(const QImage& image, int tileSize)
+    : tileSize{ tileSize }
+{
+    auto timer = QElapsedTimer{};
+    timer.start();
+
+    levels.push_back(image.convertToFormat(IDataAccess::imageFormat));
+    while (levels.back().width() > tileSize || levels.back().height() > tileSize)
+        levels.push_back(halve(levels.back()));
+
+    Logger::debug("Built " + QString::number(levels.size()) + " levels of detail in " +
+                  QString::number(toDouble(timer.nsecsElapsed()) / 1e6, 'f', 2) + " ms");
+}
+
+auto TilePyramid::getTileCount(int level) const -> QSize
+{
+    const auto& img = getLevel(level);
+    return { (img.width() + tileSize - 1) / tileSize, (img.height() + tileSize - 1) / tileSize };
+}
+
+auto TilePyramid::getTileRect(int level, int x, int y) const -> QRect
+{
+    return QRect{ x * tileSize, y * tileSize, tileSize, tileSize }.intersected(getLevel(level).rect());
+}
+
+// the levels are scaled by the ratio of their sizes, which is not exactly a power of two when a size was odd
+auto TilePyramid::toImageRect(int level, const QRectF& levelRect) const -> QRectF
+{
+    const auto sx = toDouble(levels.front().width()) / toDouble(getLevel(level).width());
+    const auto sy = toDouble(levels.front().height()) / toDouble(getLevel(level).height());
+
+    return { levelRect.x() * sx, levelRect.y() * sy, levelRect.width() * sx, levelRect.height() * sy };
+}
+
+auto TilePyramid::toLevelRect(int level, const QRectF& imageRect) const -> QRectF
+{
+    const auto sx = toDouble(getLevel(level).width()) / toDouble(levels.front().width());
+    const auto sy = toDouble(getLevel(level).height()) / toDouble(levels.front().height());
+
+    return { imageRect.x() * sx, imageRect.y() * sy, imageRect.width() * sx, imageRect.height() * sy };
+}
+
+// rounded, so that a level is minified by at most about 1.4 times, which a linear filter handles well enough
+auto TilePyramid::levelForZoom(float zoom) const -> int
+{
+    if (zoom <= 0.0f)
+        return getLevelCount() - 1;
+
+    const auto level = toInt(std::lround(std::log2(1.0f / zoom)));
+    return std::clamp(level, 0, getLevelCount() - 1);
+}
+
+auto TilePyramid::extractTile(int level, int x, int y) const -> QImage
+{
+    const auto& img = getLevel(level);
+    const auto rect = getTileRect(level, x, y);
+
+    auto tile = QImage{ rect.width() + 2, rect.height() + 2, IDataAccess::imageFormat };
+
+    for (int row = 0; row < tile.height(); ++row)
+    {
+        const auto src = reinterpret_cast<const QRgb*>(img.constScanLine(std::clamp(rect.top() + row - 1, 0, img.height() - 1)));
+        const auto dst = reinterpret_cast<QRgb*>(tile.scanLine(row));
+
+        for (int col = 0; col < tile.width(); ++col)
+            dst[col] = src[std::clamp(rect.left() + col - 1, 0, img.width() - 1)];
+    }
+
+    return tile;
+}
+
+auto TilePyramid::halve(const QImage& image) -> QImage
+{
+    const auto width  = image.width();
+    const auto height = image.height();
+
+    auto result = QImage{ (width + 1) / 2, (height + 1) / 2, IDataAccess::imageFormat };
+
+    // query the pointer once, since bits() may detach, which is not safe from multiple threads
+    const auto bits = result.bits();
+    const auto bpl  = result.bytesPerLine();
+
+    util::parallel_for(std::size_t(result.height()), [&](std::size_t index) {
+        const auto y   = toInt(index);
+        const auto src = std::array<const QRgb*, 2>{
+            reinterpret_cast<const QRgb*>(image.constScanLine(2 * y)),
+            reinterpret_cast<const QRgb*>(image.constScanLine(std::min(2 * y + 1, height - 1)))
+        };
+        const auto dst = reinterpret_cast<QRgb*>(bits + y * bpl);
+
+        for (int x = 0; x < (width + 1) / 2; ++x)
+        {
+            const auto x0 = 2 * x, x1 = std::min(2 * x + 1, width - 1);
+            const auto p  = std::array<QRgb, 4>{ src[0][x0], src[0][x1], src[1][x0], src[1][x1] };
+
+            // the channel at shift of the four pixels, averaged and rounded
+            const auto average = [&p](uint shift) {
+                return (((p[0] >> shift) & 0xffu) + ((p[1] >> shift) & 0xffu) +
+                        ((p[2] >> shift) & 0xffu) + ((p[3] >> shift) & 0xffu) + 2u) / 4u;
+            };
+
+            dst[x] = (average(24u) << 24) | (average(16u) << 16) | (average(8u) << 8) | average(0u);
+        }
+    });
+
+    return result;
+}
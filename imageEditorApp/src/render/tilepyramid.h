@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vector>
+#include <QImage>
+#include <QRect>
+#include <QRectF>
+#include <QSize>
+
+// TilePyramid: The levels of detail of an image for a virtual texture. Every level is half the size of the
+//              previous one, rounded up, down to the first one that fits into a single tile, and is cut into
+//              tiles of tileSize pixels, the ones on the right and bottom edges being smaller. The first level
+//              shares the image's pixels, the others are built by averaging, all of them up front, so that
+//              loading a tile is only a copy. Rows are in the image's order, like the textures'.
+class TilePyramid
+{
+public:
+    explicit TilePyramid(const QImage& image, int tileSize);
+
+    auto getTileSize() const -> int                   { return tileSize; }
+    auto getLevelCount() const -> int                 { return static_cast<int>(levels.size()); }
+    auto getLevel(int level) const -> const QImage&   { return levels[static_cast<std::size_t>(level)]; }
+
+    // the columns and rows of tiles of a level
+    auto getTileCount(int level) const -> QSize;
+
+    // the pixels of the level that a tile covers
+    auto getTileRect(int level, int x, int y) const -> QRect;
+
+    // conversions between the pixels of a level and the pixels of the first one
+    auto toImageRect(int level, const QRectF& levelRect) const -> QRectF;
+    auto toLevelRect(int level, const QRectF& imageRect) const -> QRectF;
+
+    // the level whose pixels are closest to the size of a display pixel, a zoom of 1 shows the image 1:1
+    auto levelForZoom(float zoom) const -> int;
+
+    // the tile's pixels with a border of one pixel around them, so that a linearly filtered texture does not
+    // sample the tiles next to it; the border repeats the pixels on the edges of the level
+    auto extractTile(int level, int x, int y) const -> QImage;
+
+    // every pixel is the average of the (up to) four pixels it replaces
+    static auto halve(const QImage& image) -> QImage;
+
+private:
+    const int           tileSize;
+    std::vector<QImage> levels;
+};
@@ -0,0 +1,253 @@
+#include "virtualtexture.h"
+#include <logger.h>
+
+#include <algorithm>
+
+using namespace util::types;
+
+const int VirtualTexture::tileSize{ 256 };
+const int VirtualTexture::maxAtlasSize{ 8192 };     // 961 tiles in 256 MiB
+const int VirtualTexture::uploadsPerFrame{ 16 };    // 4 MiB
+
+VirtualTexture::VirtualTexture(std::shared_ptr<const TilePyramid> pyramid, int maxTextureSize)
+    : pyramid{ std::move(pyramid) }
+    , slotSize{ tileSize + 2 }
+    , slotsPerRow{ std::max(1, std::min(maxAtlasSize, maxTextureSize) / slotSize) }
+    , atlas{ util::make_owner<QOpenGLTexture>(QOpenGLTexture::Target2D) }
+{
+    // no mip levels, the pyramid is chosen so that a tile is minified by not much more than its level's scale
+    atlas->setFormat(QOpenGLTexture::RGBA8_UNorm);
+    atlas->setSize(slotsPerRow * slotSize, slotsPerRow * slotSize);
+    atlas->setMipLevels(1);
+    atlas->allocateStorage(QOpenGLTexture::BGRA, QOpenGLTexture::UInt32_RGBA8_Rev);
+    atlas->setMagnificationFilter(QOpenGLTexture::Nearest);
+    atlas->setMinificationFilter(QOpenGLTexture::Linear);
+    atlas->setWrapMode(QOpenGLTexture::ClampToEdge);
+
+    // the first slots are taken first
+    for (int slot = getSlotCount() - 1; slot >= 0; --slot)
+        freeSlots.push_back(slot);
+
+    // the coarsest level, which every other tile falls back to
+    const auto top = pyramid->getLevelCount() - 1;
+    const auto slot = *acquireSlot();
+    upload(slot, top, 0, 0);
+    pageTable.emplace(key(top, 0, 0), Entry{ slot, frame });
+
+    Logger::debug("Created a virtual texture of " + QString::number(pyramid->getLevelCount()) + " levels, with " +
+                  QString::number(getSlotCount()) + " tiles in the atlas");
+}
+
+VirtualTexture::VirtualTexture(const QImage& image, int maxTextureSize)
+    : VirtualTexture{ std::make_shared<const TilePyramid>(image, tileSize), maxTextureSize } { }
+
+// the owner should have released the atlas, see releaseAtlas
+VirtualTexture::~VirtualTexture()
+{
+    atlas.reset();
+}
+
+auto VirtualTexture::prepare(const QRectF& visibleRect, float zoom) -> std::vector<Tile>
+{
+    ++frame;
+    uploads = 0;
+    pendingTiles = false;
+
+    auto tiles = std::vector<Tile>{};
+
+    const auto& image = pyramid->getLevel(0);
+    const auto visible = visibleRect.intersected(QRectF{ 0.0, 0.0, toDouble(image.width()), toDouble(image.height()) });
+    if (visible.isEmpty())
+        return tiles;
+
+    const auto level = pyramid->levelForZoom(zoom);
+    const auto range = tileRange(level, pyramid->toLevelRect(level, visible));
+
+    // the resident tiles are marked as used first, so that loading the missing ones does not evict them
+    auto missing = std::vector<QPoint>{};
+    for (int y = range.top(); y <= range.bottom(); ++y)
+    {
+        for (int x = range.left(); x <= range.right(); ++x)
+        {
+            const auto it = pageTable.find(key(level, x, y));
+            if (it != pageTable.end())
+            {
+                ++counters.hits;
+                it->second.lastUsed = frame;
+
+                const auto tileRect = pyramid->getTileRect(level, x, y);
+                tiles.push_back({ pyramid->toImageRect(level, tileRect), atlasRect(it->second.slot, tileRect, tileRect) });
+            }
+            else
+            {
+                ++counters.misses;
+                missing.emplace_back(x, y);
+            }
+        }
+    }
+
+    for (const auto& tile : missing)
+    {
+        const auto tileRect = pyramid->getTileRect(level, tile.x(), tile.y());
+        const auto imageRect = pyramid->toImageRect(level, tileRect);
+
+        if (const auto entry = load(level, tile.x(), tile.y()))
+        {
+            tiles.push_back({ imageRect, atlasRect(entry->slot, tileRect, tileRect) });
+            continue;
+        }
+
+        // the coarsest level always covers it
+        for (int coarser = level + 1; coarser < pyramid->getLevelCount(); ++coarser)
+            if (cover(coarser, imageRect, tiles))
+                break;
+    }
+
+    return tiles;
+}
+
+auto VirtualTexture::takeUploadedBytes() -> qint64
+{
+    const auto bytes = uploadedBytes;
+    uploadedBytes = 0;
+
+    return bytes;
+}
+
+auto VirtualTexture::stats() const -> CacheStats
+{
+    const auto slotBytes = std::size_t(slotSize) * std::size_t(slotSize) * 4u;
+
+    auto stats = counters;
+    stats.images = pageTable.size();
+    stats.bytes  = stats.images * slotBytes;
+    stats.budget = std::size_t(getSlotCount()) * slotBytes;
+
+    return stats;
+}
+
+// the level in the highest bits, a level has less than 2^24 tiles in either direction
+auto VirtualTexture::key(int level, int x, int y) -> quint64
+{
+    return (quint64(level) << 48) | (quint64(y) << 24) | quint64(x);
+}
+
+auto VirtualTexture::levelOf(quint64 key) -> int
+{
+    return toInt(key >> 48);
+}
+
+// the columns and rows of the tiles that the rect of the level touches, both ends included
+auto VirtualTexture::tileRange(int level, const QRectF& levelRect) const -> QRect
+{
+    const auto count = pyramid->getTileCount(level);
+    const auto size  = toDouble(tileSize);
+
+    return QRect{ QPoint{ std::clamp(util::floor(levelRect.left() / size), 0, count.width() - 1),
+                          std::clamp(util::floor(levelRect.top() / size), 0, count.height() - 1) },
+                  QPoint{ std::clamp(util::ceil(levelRect.right() / size) - 1, 0, count.width() - 1),
+                          std::clamp(util::ceil(levelRect.bottom() / size) - 1, 0, count.height() - 1) } };
+}
+
+// nothing if the budget of the frame is spent, or if every slot holds a tile of the current frame
+auto VirtualTexture::load(int level, int x, int y) -> const Entry*
+{
+    if (uploads >= uploadsPerFrame)
+    {
+        pendingTiles = true;
+        return nullptr;
+    }
+
+    const auto slot = acquireSlot();
+    if (!slot)
+        return nullptr;
+
+    upload(*slot, level, x, y);
+    ++uploads;
+
+    return &pageTable.insert_or_assign(key(level, x, y), Entry{ *slot, frame }).first->second;
+}
+
+// the least recently used tile is evicted, apart from the coarsest one, a linear search is fine for the few
+// hundred tiles of the atlas and the few evictions per frame
+auto VirtualTexture::acquireSlot() -> std::optional<int>
+{
+    if (!freeSlots.empty())
+    {
+        const auto slot = freeSlots.back();
+        freeSlots.pop_back();
+
+        return slot;
+    }
+
+    const auto top = pyramid->getLevelCount() - 1;
+    auto lru = pageTable.end();
+
+    for (auto it = pageTable.begin(); it != pageTable.end(); ++it)
+        if (levelOf(it->first) != top && it->second.lastUsed < frame &&
+            (lru == pageTable.end() || it->second.lastUsed < lru->second.lastUsed))
+            lru = it;
+
+    if (lru == pageTable.end())
+        return std::nullopt;
+
+    const auto slot = lru->second.slot;
+    pageTable.erase(lru);
+
+    return slot;
+}
+
+void VirtualTexture::upload(int slot, int level, int x, int y)
+{
+    const auto tile = pyramid->extractTile(level, x, y);
+
+    atlas->setData((slot % slotsPerRow) * slotSize, (slot / slotsPerRow) * slotSize, 0, tile.width(), tile.height(), 0,
+                   QOpenGLTexture::PixelFormat::BGRA, QOpenGLTexture::UInt32_RGBA8_Rev, tile.constBits());
+
+    uploadedBytes += tile.sizeInBytes();
+}
+
+// the parts of the level's tiles that cover the rect of the image, only if all of them are resident; the sizes of
+// the levels are rounded, so the rect may span the edges of the coarser tiles, even if it is a tile itself
+auto VirtualTexture::cover(int level, const QRectF& imageRect, std::vector<Tile>& tiles) -> bool
+{
+    const auto levelRect = pyramid->toLevelRect(level, imageRect);
+    const auto range = tileRange(level, levelRect);
+
+    auto used = std::vector<Entry*>{};
+    auto parts = std::vector<Tile>{};
+
+    for (int y = range.top(); y <= range.bottom(); ++y)
+    {
+        for (int x = range.left(); x <= range.right(); ++x)
+        {
+            const auto it = pageTable.find(key(level, x, y));
+            if (it == pageTable.end())
+                return false;
+
+            const auto tileRect = pyramid->getTileRect(level, x, y);
+            const auto part = levelRect.intersected(QRectF{ tileRect });
+            if (part.isEmpty())
+                continue;
+
+            used.push_back(&it->second);
+            parts.push_back({ pyramid->toImageRect(level, part), atlasRect(it->second.slot, part, tileRect) });
+        }
+    }
+
+    for (const auto entry : used)
+        entry->lastUsed = frame;
+
+    tiles.insert(tiles.end(), parts.begin(), parts.end());
+    return true;
+}
+
+// the tile's pixels start one texel into its slot, after the border
+auto VirtualTexture::atlasRect(int slot, const QRectF& levelRect, const QRect& tileRect) const -> QRectF
+{
+    const auto size = toDouble(atlas->width());
+    const auto x = toDouble((slot % slotsPerRow) * slotSize + 1 - tileRect.left()) + levelRect.x();
+    const auto y = toDouble((slot / slotsPerRow) * slotSize + 1 - tileRect.top()) + levelRect.y();
+
+    return { x / size, y / size, levelRect.width() / size, levelRect.height() / size };
+}
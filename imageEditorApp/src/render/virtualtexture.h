@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cachestats.h>
+#include "tilepyramid.h"
+#include <util.h>
+
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+#include <QImage>
+#include <QOpenGLTexture>
+#include <QRect>
+#include <QRectF>
+
+// VirtualTexture: Shows an image that is too large for a texture of its own through an atlas of a fixed size,
+//                 whose slots hold the tiles of a TilePyramid that the view needs. The page table maps the
+//                 resident tiles to their slots; a tile that is not resident yet is drawn from the resident
+//                 tiles of a coarser level meanwhile, the coarsest level being a single tile that is always
+//                 resident. When the atlas is full, the least recently used tiles are evicted, never the ones
+//                 of the current frame. Only a few tiles are loaded per frame, so that panning does not stall.
+//                 Every function expects the GL context it was created in to be current.
+class VirtualTexture
+{
+public:
+    static const int tileSize;
+    static const int maxAtlasSize;
+    static const int uploadsPerFrame;
+
+    // a part of the image, in its pixels, and where they are in the atlas, in its texture coordinates
+    struct Tile
+    {
+        QRectF imageRect;
+        QRectF atlasRect;
+    };
+
+    // the atlas is square, and not larger than the implementation's largest texture; the pyramid may be shared
+    // with other virtual textures of the same image, since building it takes a while for a large one
+    explicit VirtualTexture(std::shared_ptr<const TilePyramid> pyramid, int maxTextureSize);
+    explicit VirtualTexture(const QImage& image, int maxTextureSize);
+    ~VirtualTexture();
+
+    VirtualTexture(const VirtualTexture&) = delete;
+    VirtualTexture& operator=(const VirtualTexture&) = delete;
+
+    // loads the missing tiles of the visible part of the image, in the level for the zoom, as far as the
+    // budget of the frame allows, and returns the tiles that cover it; one call per frame
+    auto prepare(const QRectF& visibleRect, float zoom) -> std::vector<Tile>;
+
+    // some tiles of the last frame were drawn from a coarser level, since the budget of the frame was spent
+    auto hasPendingTiles() const -> bool                      { return pendingTiles; }
+    auto takeUploadedBytes() -> qint64;
+    auto stats() const -> CacheStats;
+
+    auto getPyramid() const -> const TilePyramid&             { return *pyramid; }
+    auto getSlotCount() const -> int                          { return slotsPerRow * slotsPerRow; }
+    auto getAtlas() -> QOpenGLTexture&                        { return *atlas; }
+    auto getAtlas() const -> const QOpenGLTexture&            { return *atlas; }
+
+    // hands the atlas over to be deleted by its owner, nothing can be drawn afterwards
+    auto releaseAtlas() -> util::owner_ptr<QOpenGLTexture>    { return std::move(atlas); }
+
+private:
+    struct Entry
+    {
+        int     slot;
+        quint64 lastUsed;   // the frame that last drew the tile
+    };
+
+    using PageTable = std::unordered_map<quint64, Entry>;
+
+    const std::shared_ptr<const TilePyramid> pyramid;
+    const int                                slotSize;       // a tile with its border
+    const int                                slotsPerRow;
+    util::owner_ptr<QOpenGLTexture>          atlas;
+    PageTable                                pageTable;      // keyed by the level and the column and row of the tile
+    std::vector<int>                         freeSlots;
+    quint64                                  frame{ 0u };
+    int                                      uploads{ 0 };   // in the current frame
+    bool                                     pendingTiles{ false };
+    qint64                                   uploadedBytes{ 0 };     // since the last call to takeUploadedBytes
+    CacheStats                               counters;
+
+    static auto key(int level, int x, int y) -> quint64;
+    static auto levelOf(quint64 key) -> int;
+
+    auto tileRange(int level, const QRectF& levelRect) const -> QRect;
+    auto load(int level, int x, int y) -> const Entry*;
+    auto acquireSlot() -> std::optional<int>;
+    void upload(int slot, int level, int x, int y);
+    auto cover(int level, const QRectF& imageRect, std::vector<Tile>& tiles) -> bool;
+    auto atlasRect(int slot, const QRectF& levelRect, const QRect& tileRect) const -> QRectF;
+};
@@ -0,0 +1,392 @@
+#include "batchprocessor.h"
+#include <editorfactory.h>
+#include <logger.h>
+
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <set>
+#include <thread>
+#include <vector>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QThread>
+
+using namespace util::types;
+
+const QString BatchProcessor::batchOption{ "batch" };
+
+namespace
+{
+    void print(const QString& message)
+    {
+        QTextStream{ stdout } << message << Qt::endl;
+    }
+
+    void printError(const QString& message)
+    {
+        QTextStream{ stderr } << message << Qt::endl;
+    }
+}
+
+auto BatchProcessor::isRequested(int argc, char* argv[]) -> bool
+{
+    const auto option = "--" + batchOption.toStdString();
+
+    for (int i = 1; i < argc; ++i)
+        if (std::strcmp(argv[i], option.c_str()) == 0)
+            return true;
+
+    return false;
+}
+
+auto BatchProcessor::parseArguments(const QStringList& arguments) -> std::optional<Options>
+{
+    auto parser = QCommandLineParser{};
+    parser.setApplicationDescription("Runs the editor's operations on a list of images, without opening a window.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("files", "The images to process.", "[files...]");
+
+    const auto batchOpt      = QCommandLineOption{ batchOption, "Run in batch mode." };
+    const auto listOpt       = QCommandLineOption{ "list", "Also process the images listed in <file>, one path per line.", "file" };
+    const auto outputOpt     = QCommandLineOption{ { "o", "output" }, "Write the results into <dir>.", "dir" };
+    const auto formatOpt     = QCommandLineOption{ { "f", "format" }, "Convert the results to <format> (png, jpg, bmp, ppm, xpm). "
+                                                                      "The format of the input is kept by default.", "format" };
+    const auto rotateOpt     = QCommandLineOption{ { "r", "rotate" }, "Rotate counter-clockwise by <degrees>.", "degrees", "0" };
+    const auto interpOpt     = QCommandLineOption{ "interp", "Interpolation used by rotation: nearest or bilinear.", "method", "bilinear" };
+    const auto mirrorOpt     = QCommandLineOption{ "mirror", "Mirror horizontally (h), vertically (v) or both (hv).", "axes" };
+    const auto redOpt        = QCommandLineOption{ "red", "Red level in [0, 1], 0.5 leaves it unchanged.", "level", "0.5" };
+    const auto greenOpt      = QCommandLineOption{ "green", "Green level in [0, 1], 0.5 leaves it unchanged.", "level", "0.5" };
+    const auto blueOpt       = QCommandLineOption{ "blue", "Blue level in [0, 1], 0.5 leaves it unchanged.", "level", "0.5" };
+    const auto brightnessOpt = QCommandLineOption{ "brightness", "Brightness in [-0.5, 0.5], 0 leaves it unchanged.", "level", "0" };
+    const auto contrastOpt   = QCommandLineOption{ "contrast", "Contrast in [0, 5], 1 leaves it unchanged.", "level", "1" };
+    const auto compressOpt   = QCommandLineOption{ { "z", "compression" }, "PNG compression level in [0, 9], "
+                                                                           "from the fastest to the smallest.", "level",
+                                                   QString::number(IDataAccess::defaultCompressionLevel) };
+    const auto jobsOpt       = QCommandLineOption{ { "j", "jobs" }, "Number of worker threads of each stage. "
+                                                                    "The number of cores is used by default.", "n" };
+    const auto debugOpt      = QCommandLineOption{ { "d", "debug" }, "Print debug messages." };
+
+    parser.addOptions({ batchOpt, listOpt, outputOpt, formatOpt, rotateOpt, interpOpt, mirrorOpt, redOpt, greenOpt,
+                        blueOpt, brightnessOpt, contrastOpt, compressOpt, jobsOpt, debugOpt });
+
+    if (!parser.parse(arguments))
+    {
+        printError(parser.errorText());
+        return {};
+    }
+
+    if (parser.isSet("help"))
+        parser.showHelp();
+
+    auto options = Options{};
+    auto valid   = true;
+
+    const auto readFloat = [&](const QCommandLineOption& option, float low, float high, float& dest) {
+        auto ok = false;
+        const auto value = parser.value(option).toFloat(&ok);
+
+        if (!ok || value < low || value > high)
+        {
+            printError("Invalid value for --" + option.names().last() + ": " + parser.value(option));
+            valid = false;
+            return;
+        }
+
+        dest = value;
+    };
+
+    readFloat(rotateOpt, -360.0f, 360.0f, options.rotate);
+    readFloat(redOpt, 0.0f, 1.0f, options.colorData.red);
+    readFloat(greenOpt, 0.0f, 1.0f, options.colorData.green);
+    readFloat(blueOpt, 0.0f, 1.0f, options.colorData.blue);
+    readFloat(brightnessOpt, -0.5f, 0.5f, options.colorData.bright);
+    readFloat(contrastOpt, 0.0f, 5.0f, options.colorData.contrast);
+
+    const auto interp = parser.value(interpOpt);
+    if (interp == "nearest")
+        options.interpMethod = IEditor::InterpMethod::NEAREST;
+    else if (interp == "bilinear")
+        options.interpMethod = IEditor::InterpMethod::BILINEAR;
+    else
+    {
+        printError("Invalid interpolation method: " + interp);
+        valid = false;
+    }
+
+    const auto mirror = parser.value(mirrorOpt);
+    options.mirrorHorizontally = mirror.contains("h");
+    options.mirrorVertically   = mirror.contains("v");
+
+    auto levelOk = false;
+    options.compressionLevel = parser.value(compressOpt).toInt(&levelOk);
+    if (!levelOk || options.compressionLevel < 0 || options.compressionLevel > 9)
+    {
+        printError("Invalid compression level: " + parser.value(compressOpt));
+        valid = false;
+    }
+
+    options.jobs = QThread::idealThreadCount();
+    if (parser.isSet(jobsOpt))
+    {
+        auto ok = false;
+        options.jobs = parser.value(jobsOpt).toInt(&ok);
+        if (!ok || options.jobs < 1)
+        {
+            printError("Invalid number of jobs: " + parser.value(jobsOpt));
+            valid = false;
+        }
+    }
+
+    options.format = parser.value(formatOpt).toLower();
+    options.debug  = parser.isSet(debugOpt);
+    options.inputs = parser.positionalArguments();
+
+    if (parser.isSet(listOpt))
+    {
+        auto list = QFile{ parser.value(listOpt) };
+        if (!list.open(QIODevice::ReadOnly | QIODevice::Text))
+        {
+            printError("Failed to open file list " + list.fileName());
+            return {};
+        }
+
+        auto stream = QTextStream{ &list };
+        while (!stream.atEnd())
+        {
+            const auto line = stream.readLine().trimmed();
+            if (!line.isEmpty())
+                options.inputs.append(line);
+        }
+    }
+
+    if (options.inputs.isEmpty())
+    {
+        printError("No input files given");
+        valid = false;
+    }
+
+    options.outputDir = parser.value(outputOpt);
+    if (options.outputDir.isEmpty() || !QDir{}.mkpath(options.outputDir))
+    {
+        printError("Missing or invalid output directory: " + options.outputDir);
+        valid = false;
+    }
+
+    if (!valid)
+        return {};
+
+    return options;
+}
+
+auto BatchProcessor::run() -> int
+{
+    Logger::setDebug(options.debug);
+
+    const auto start = Clock::now();
+    const auto jobs  = std::size_t(options.jobs);
+    const auto count = std::size_t(options.inputs.size());
+
+    // the queues are bounded, so that a fast stage can not pile up decoded images in memory
+    auto decoded   = util::blocking_queue<Job>{ jobs };
+    auto processed = util::blocking_queue<Job>{ jobs };
+    auto next      = std::atomic_size_t{ 0u };
+
+    const auto outputs = outputPaths();
+
+    // the stages have a thread per job each already, so the work on a single image is not spread over all
+    // the cores again, which would run the square of their number of threads at once
+    const auto spawn = [jobs](const std::function<void()>& work) {
+        auto threads = std::vector<std::thread>{};
+        for (std::size_t i = 0; i < jobs; ++i)
+            threads.emplace_back([&work] {
+                const auto serial = util::serial_scope{};
+                work();
+            });
+
+        return threads;
+    };
+
+    const auto join = [](std::vector<std::thread>& threads) {
+        for (auto& thread : threads)
+            thread.join();
+    };
+
+    auto decoders = spawn([&] {
+        for (auto i = next++; i < count; i = next++)
+        {
+            auto job = Job{};
+            job.input  = options.inputs[toInt(i)];
+            job.output = outputs[toInt(i)];
+
+            if (decode(job))
+                decoded.push(std::move(job));
+        }
+    });
+
+    auto processors = spawn([&] {
+        while (auto job = decoded.pop())
+        {
+            process(*job);
+            processed.push(std::move(*job));
+        }
+    });
+
+    auto encoders = spawn([&] {
+        while (auto job = processed.pop())
+            if (encode(*job))
+                reportFile(*job);
+    });
+
+    // a stage is done once the previous one has finished, and its queue has been drained
+    join(decoders);
+    decoded.close();
+    join(processors);
+    processed.close();
+    join(encoders);
+
+    reportTotal(Clock::now() - start);
+
+    return failed == 0u ? 0 : 1;
+}
+
+// inputs of the same name from different directories would overwrite each other's results, so the later ones
+// get a number appended to their names
+auto BatchProcessor::outputPaths() const -> QStringList
+{
+    auto paths = QStringList{};
+    auto taken = std::set<QString>{};
+
+    for (const auto& input : options.inputs)
+    {
+        const auto info   = QFileInfo{ input };
+        const auto suffix = options.format.isEmpty() ? info.suffix() : options.format;
+        const auto dir    = QDir{ options.outputDir };
+
+        const auto first = dir.filePath(info.completeBaseName() + "." + suffix);
+
+        // compared without case, for the file systems that ignore it
+        auto path = first;
+        for (int i = 2; taken.count(path.toLower()) > 0u; ++i)
+            path = dir.filePath(info.completeBaseName() + "-" + QString::number(i) + "." + suffix);
+
+        if (path != first)
+            printError("The result of " + input + " is written to " + path + ", since " + first + " is taken");
+
+        taken.insert(path.toLower());
+        paths.append(path);
+    }
+
+    return paths;
+}
+
+auto BatchProcessor::decode(Job& job) -> bool
+{
+    const auto start = Clock::now();
+
+    job.editor = fact::makeEditor(options.interpMethod, options.debug);
+    job.editor->setCompressionLevel(options.compressionLevel);
+
+    const auto img = job.editor->loadImage(job.input);
+    if (!img)
+    {
+        reportFailure(job, "decode");
+        return false;
+    }
+
+    job.image      = *img;
+    job.inputBytes = QFileInfo{ job.input }.size();
+    job.decodeMs   = elapsedMs(start);
+
+    return true;
+}
+
+void BatchProcessor::process(Job& job)
+{
+    const auto start = Clock::now();
+
+    auto img = job.image;
+
+    if (options.mirrorHorizontally || options.mirrorVertically)
+        img = img.mirrored(options.mirrorHorizontally, options.mirrorVertically);
+
+    // rotation works like in the editor: the image keeps its size, and uncovered areas are black
+    if (options.rotate != 0.0f)
+    {
+        auto background = QImage{ img.size(), img.format() };
+        background.fill(Qt::black);
+
+        img = job.editor->mergeImages(background, img, img.rect(), options.rotate);
+    }
+
+    img = job.editor->adjustColors(img, options.colorData);
+
+    job.editor->appendHistory(img);
+    job.image     = img;
+    job.processMs = elapsedMs(start);
+}
+
+auto BatchProcessor::encode(Job& job) -> bool
+{
+    const auto start = Clock::now();
+
+    if (!job.editor->saveImage(job.output))
+    {
+        reportFailure(job, "encode");
+        return false;
+    }
+
+    job.encodeMs = elapsedMs(start);
+    job.editor.reset();
+
+    return true;
+}
+
+void BatchProcessor::reportFile(const Job& job)
+{
+    const auto megapixels = toDouble(job.image.width()) * toDouble(job.image.height()) / 1e6;
+    const auto totalMs    = std::max<qint64>(1, job.decodeMs + job.processMs + job.encodeMs);
+
+    auto lock = std::lock_guard<std::mutex>{ outputMutex };
+
+    ++finished;
+    totalMegapixels += megapixels;
+    totalInputBytes += job.inputBytes;
+
+    print(QString{ "[%1/%2] %3 -> %4: %5 MP, decode %6 ms, process %7 ms, encode %8 ms, %9 MP/s" }
+          .arg(finished + failed).arg(options.inputs.size()).arg(job.input, job.output)
+          .arg(megapixels, 0, 'f', 1).arg(job.decodeMs).arg(job.processMs).arg(job.encodeMs)
+          .arg(megapixels * 1000.0 / toDouble(totalMs), 0, 'f', 1));
+}
+
+void BatchProcessor::reportFailure(const Job& job, const QString& stage)
+{
+    auto lock = std::lock_guard<std::mutex>{ outputMutex };
+
+    ++failed;
+    printError(QString{ "[%1/%2] %3: failed to %4" }.arg(finished + failed).arg(options.inputs.size())
+               .arg(job.input, stage));
+}
+
+void BatchProcessor::reportTotal(Clock::duration elapsed)
+{
+    const auto seconds = std::max(0.001, std::chrono::duration<double>(elapsed).count());
+
+    print(QString{ "Processed %1 of %2 files in %3 s with %4 threads per stage: "
+                   "%5 files/s, %6 MP/s, %7 MB/s read" }
+          .arg(finished).arg(options.inputs.size()).arg(seconds, 0, 'f', 2).arg(options.jobs)
+          .arg(toDouble(finished) / seconds, 0, 'f', 1)
+          .arg(totalMegapixels / seconds, 0, 'f', 1)
+          .arg(toDouble(totalInputBytes) / 1e6 / seconds, 0, 'f', 1));
+
+    if (failed > 0u)
+        printError(QString::number(failed) + " files failed");
+}
+
+auto BatchProcessor::elapsedMs(Clock::time_point start) -> qint64
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count();
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <colordata.h>
+#include <idataaccess.h>
+#include <ieditor.h>
+#include <util.h>
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <QImage>
+#include <QString>
+#include <QStringList>
+
+// BatchProcessor: Runs the editor's operations on a list of files, without a display.
+//                 Files go through a pipeline of three stages (decode, process, encode),
+//                 each with its own pool of worker threads, connected by bounded queues,
+//                 so that reading, processing and writing different files overlap.
+//                 Every file gets its own editor, which is handed from stage to stage, and is
+//                 worked on by a single thread of each stage, see util::serial_scope.
+class BatchProcessor
+{
+public:
+    static const QString batchOption;
+
+    struct Options
+    {
+        QStringList           inputs;
+        QString               outputDir;
+        QString               format;                        // output suffix, empty to keep the input's
+        float                 rotate{ 0.0f };                // counter-clockwise, in degrees
+        IEditor::InterpMethod interpMethod{ IEditor::InterpMethod::BILINEAR };
+        bool                  mirrorHorizontally{ false };
+        bool                  mirrorVertically{ false };
+        ColorData             colorData;
+        int                   compressionLevel{ IDataAccess::defaultCompressionLevel };
+        int                   jobs{ 1 };                     // threads per stage
+        bool                  debug{ false };
+    };
+
+    static auto isRequested(int argc, char* argv[]) -> bool;
+    static auto parseArguments(const QStringList& arguments) -> std::optional<Options>;
+
+    explicit BatchProcessor(Options options) : options{ std::move(options) } { }
+
+    auto run() -> int;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Job
+    {
+        QString                  input;
+        QString                  output;
+        std::unique_ptr<IEditor> editor;
+        QImage                   image;
+        qint64                   inputBytes{ 0 };
+        qint64                   decodeMs{ 0 };
+        qint64                   processMs{ 0 };
+        qint64                   encodeMs{ 0 };
+    };
+
+    const Options options;
+
+    std::mutex   outputMutex;
+    std::size_t  finished{ 0u };
+    std::size_t  failed{ 0u };
+    double       totalMegapixels{ 0.0 };
+    qint64       totalInputBytes{ 0 };
+
+    auto outputPaths() const -> QStringList;
+
+    auto decode(Job& job) -> bool;
+    void process(Job& job);
+    auto encode(Job& job) -> bool;
+
+    void reportFile(const Job& job);
+    void reportFailure(const Job& job, const QString& stage);
+    void reportTotal(Clock::duration elapsed);
+
+    static auto elapsedMs(Clock::time_point start) -> qint64;
+};
@@ -1,10 +0,0 @@
-#pragma once
-
-struct ColorData
-{
-    float red{ 0.5f };
-    float green{ 0.5f };
-    float blue{ 0.5f };
-    float bright{ 0.0f };
-    float contrast{ 1.0f };
-};
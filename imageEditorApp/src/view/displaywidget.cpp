@@ -6,33 +6,104 @@
 #include "displaywidget.h"
 #include "coordconverter.h"
 #include <logger.h>
-#include "openglexception.h"
+#include <openglexception.h>
 #include <util.h>
 
+#include <algorithm>
 #include <array>
 #include <limits>
 #include <optional>
+#include <vector>
 #include <QApplication>
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QMouseEvent>
-#include <QOpenGLFramebufferObject>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
 #include <QPoint>
 #include <QPainter>
-#include <QPolygon>
 #include <QTransform>
 
-const int   DisplayWidget::vertexAttribLoc{ 0 };
-const int   DisplayWidget::texcoordAttribLoc{ 1 };
 const float DisplayWidget::zoomStep{ 0.25f };
+
+// while a layer of a large image is moved or the display is resized, the frame is drawn at a quarter of the pixels
+const int    DisplayWidget::previewDownscale{ 2 };
+const qint64 DisplayWidget::previewMinImagePixels{ 16 * 1024 * 1024 };
+const int    DisplayWidget::previewGranularity{ 256 };
+const int    DisplayWidget::resizeSettleTime{ 150 };
+
+// the textures of the images recently shown, for undo and redo, the one on screen is not counted
+const qint64 DisplayWidget::textureCacheBudget{ qint64{ 512 } * 1024 * 1024 };
+
+// larger images are shown tile by tile through a virtual texture, as are the ones that do not fit into a texture
+const qint64 DisplayWidget::virtualTextureMinBytes{ qint64{ 1024 } * 1024 * 1024 };
+const int    DisplayWidget::fallbackMaxTextureSize{ 1024 };   // the smallest limit of OpenGL 3
+
+// trilinear when zoomed out, magnification stays nearest so that the pixels of the image are visible
+const QOpenGLTexture::Filter DisplayWidget::minificationFilter{ QOpenGLTexture::LinearMipMapLinear };
 const uint  DisplayWidget::defaultGray{ 0xbc };
 const QRgb  DisplayWidget::darkOverlayColor{ qRgba(0x00, 0x00, 0x00, 0x80) };
 const QRgb  DisplayWidget::lightOverlayColor{ qRgba(0xbc, 0xbc, 0xbc, 0x80) };
 
+namespace
+{
+    // with the whole mip chain, every format the display uses has 4 bytes per pixel
+    auto textureBytes(const QOpenGLTexture& texture) -> qint64
+    {
+        auto bytes = qint64{ 0 };
+        for (int level = 0; level < texture.mipLevels(); ++level)
+            bytes += qint64{ std::max(1, texture.width() >> level) } * std::max(1, texture.height() >> level) * 4;
+
+        return bytes;
+    }
+
+    // an image may be displayed before the display's own context is initialized, so the limit is asked from
+    // a context of the same format up front; zero if there is none
+    auto queryMaxTextureSize() -> int
+    {
+        auto context = QOpenGLContext{};
+        context.setFormat(QSurfaceFormat::defaultFormat());
+        if (!context.create())
+            return 0;
+
+        auto surface = QOffscreenSurface{};
+        surface.setFormat(context.format());
+        surface.create();
+
+        auto size = GLint{ 0 };
+        if (context.makeCurrent(&surface))
+        {
+            context.functions()->glGetIntegerv(GL_MAX_TEXTURE_SIZE, &size);
+            context.doneCurrent();
+        }
+
+        return size;
+    }
+}
+
 DisplayWidget::DisplayWidget(QWidget* parent, IMainWindow& mainWindow)
     : QOpenGLWidget{ parent }
     , mainWindow{ mainWindow }
+    , resizeTimer{ new QTimer{ this }}
+    , maxTextureSize{ queryMaxTextureSize() }
 {
+    if (maxTextureSize <= 0)
+    {
+        Logger::warning("Failed to query the largest texture, assuming " + QString::number(fallbackMaxTextureSize) +
+                        " pixels until OpenGL is initialized");
+        maxTextureSize = fallbackMaxTextureSize;
+    }
+
     setMouseTracking(true);
+
+    // the full resolution frame is drawn once the size has not changed for a while
+    resizeTimer->setSingleShot(true);
+    resizeTimer->setInterval(resizeSettleTime);
+    connect(resizeTimer, &QTimer::timeout, this, [this] {
+        resizing = false;
+        update();
+    });
 }
 
 DisplayWidget::~DisplayWidget()
@@ -40,6 +111,11 @@ DisplayWidget::~DisplayWidget()
     // OpenGL objects must be released in the current context
     makeCurrent();
 
+    streamer.reset();
+    textureCache.reset();
+    renderer.reset();
+    previewFramebuffer.reset();
+    frameStats.reset();
     frameLayer.reset();
     UpperLayer::overlayTexture.reset();
     backgroundLayer.reset();
@@ -52,40 +128,146 @@ void DisplayWidget::initializeGL()
 {
     initializeOpenGLFunctions();
     
-    // specifiy OpenGL options
-    {
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-        glEnable(GL_BLEND);
-        glEnable(GL_CULL_FACE);
-    }
-    
-    // init shaders
-    {
-        shaderProgram = makeShader(vertexShaderSource, fragmentShaderSource);
-        shaderProgram->setUniformValue("texture1", 0);
-        shaderProgram->setUniformValue("redLevel", 0.5f);
-        shaderProgram->setUniformValue("greenLevel", 0.5f);
-        shaderProgram->setUniformValue("blueLevel", 0.5f);
-        shaderProgram->setUniformValue("brightLevel", 0.0f);
-        shaderProgram->setUniformValue("contrastLevel", 1.0f);
+    setGLOptions();
 
-        grayShaderProgram = makeShader(vertexShaderSource, grayscaleFragmentShaderSource);
-
-        selectedShader = shaderProgram.get();
-    }
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+    Logger::debug("The largest texture is " + QString::number(maxTextureSize) + " pixels wide");
+    
+    renderer = std::make_unique<Renderer>();
     
     // setup vertex data
     LayerBase::defaultVbo = VertexBuffer::make();
 
+    // the worker only asks for a repaint, the buffers it filled are uploaded by paintGL
+    streamer = std::make_unique<TextureStreamer>([this] {
+        QMetaObject::invokeMethod(this, [this] { update(); }, Qt::QueuedConnection);
+    });
+
+    frameStats = std::make_unique<FrameStats>();
+
+    // the cache is only changed while the context is current, so the textures are deleted right away
+    textureCache = std::make_unique<TextureCache>(textureCacheBudget, [this](util::owner_ptr<QOpenGLTexture> texture) {
+        trackTextureMemory(*texture, false);
+        texture.reset();
+    });
+
     setOverlayColor(darkOverlayColor);
 }
 
+// QPainter changes these when the performance overlay is drawn
+void DisplayWidget::setGLOptions()
+{
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glEnable(GL_BLEND);
+    glEnable(GL_CULL_FACE);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+// QOpenGLWidget reallocates its own framebuffer, everything else is kept, the layers' transforms
+// are rebuilt lazily when they are drawn with the new size
+void DisplayWidget::resizeGL(int, int)
+{
+    resizing = true;
+    resizeTimer->start();
+}
+
 void DisplayWidget::paintGL()
 {
+    frameStats->begin();
+    renderer->invalidate();
+
+    const auto preview = beginPreview();
+
     glClearColor(toFloat(defaultGray) / 255.0f, toFloat(defaultGray) / 255.0f, toFloat(defaultGray) / 255.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+    if (backgroundLayer && !backgroundLayer->isUploaded() && streamer->poll())
+        setBackgroundUploaded();
+
     drawLayers();
+
+    if (preview)
+        endPreview();
+
+    const auto uploadedBytes = streamer->takeUploadedBytes() + (backgroundLayer ? backgroundLayer->takeUploadedBytes() : 0);
+    frameStats->end(renderer->takeUniformUpdates(), uploadedBytes);
+
+    if (hud.isEnabled())
+    {
+        {
+            auto painter = QPainter{ this };
+            hud.draw(painter, *frameStats, textureMemory, textureCache->stats(),
+                     backgroundLayer ? backgroundLayer->getTileStats() : std::nullopt);
+        }
+        setGLOptions();
+    }
+
+    queueMipLevels();
+
+    // the tiles that did not fit into the uploads of this frame are loaded by the next ones
+    if (backgroundLayer && backgroundLayer->hasPendingTiles())
+        QMetaObject::invokeMethod(this, [this] { update(); }, Qt::QueuedConnection);
+}
+
+// while a layer of a large image is dragged or rotated, or the display is resized, the frame is drawn into
+// a smaller framebuffer and scaled up, the textures are minified further there, so they are sampled from a
+// lower mip level; the framebuffer only grows, in steps, so that it is not reallocated for every resize
+auto DisplayWidget::beginPreview() -> bool
+{
+    if (!(interactive || resizing) || !backgroundLayer || !QOpenGLFramebufferObject::hasOpenGLFramebufferBlit() ||
+        qint64{ backgroundLayer->getWidth() } * backgroundLayer->getHeight() < previewMinImagePixels)
+        return false;
+
+    const auto size = previewSize();
+    const auto allocated = previewFramebuffer ? previewFramebuffer->size() : QSize{ 0, 0 };
+
+    if (allocated.width() < size.width() || allocated.height() < size.height())
+    {
+        const auto grow = [](int current, int needed) {
+            return std::max(current, (needed + previewGranularity - 1) / previewGranularity * previewGranularity);
+        };
+
+        previewFramebuffer = std::make_unique<QOpenGLFramebufferObject>(
+            QSize{ grow(allocated.width(), size.width()), grow(allocated.height(), size.height()) }, GL_TEXTURE_2D);
+    }
+
+    if (!previewFramebuffer->bind())
+        throw OpenGLException{ "Failed to bind the preview framebuffer!" };
+
+    glViewport(0, 0, size.width(), size.height());
+    return true;
+}
+
+void DisplayWidget::endPreview()
+{
+    const auto source = QRect{ QPoint{ 0, 0 }, previewSize() };
+    const auto target = QRect{ QPoint{ 0, 0 }, deviceSize() };
+
+    // a null target is the widget's own framebuffer, only the part of the preview that was drawn into is copied
+    QOpenGLFramebufferObject::blitFramebuffer(nullptr, target, previewFramebuffer.get(), source,
+                                              GL_COLOR_BUFFER_BIT, GL_LINEAR);
+
+    if (!QOpenGLFramebufferObject::bindDefault())
+        throw OpenGLException{ "Failed to rebind default framebuffer!" };
+
+    glViewport(0, 0, target.width(), target.height());
+}
+
+auto DisplayWidget::deviceSize() const -> QSize
+{
+    return { toInt(toDouble(width()) * devicePixelRatioF()), toInt(toDouble(height()) * devicePixelRatioF()) };
+}
+
+auto DisplayWidget::previewSize() const -> QSize
+{
+    const auto size = deviceSize();
+    return { std::max(1, size.width() / previewDownscale), std::max(1, size.height() / previewDownscale) };
+}
+
+void DisplayWidget::setHudEnabled(bool enable)
+{
+    hud.setEnabled(enable);
+    update();
 }
 
 void DisplayWidget::mousePressEvent(QMouseEvent* event)
@@ -123,6 +305,9 @@ void DisplayWidget::mousePressEvent(QMouseEvent* event)
         displaySettingsMgr.beginRotation(normClick, backgroundLayer->getTranslate(), backgroundLayer->getRotate());
     }
 
+    // a selection is drawn at full quality, since it snaps to the image's pixels
+    interactive = QApplication::keyboardModifiers() != Qt::ShiftModifier;
+
     emit displayFocused();
 }
 
@@ -244,12 +429,17 @@ void DisplayWidget::mouseMoveEvent(QMouseEvent* event)
     }
 
     emit cursorPositionChanged(backgroundLayer->layerCoordFromWinCoord(adjustToCamera(pixClick)));
-    
-    update();
+
+    // moving the cursor without a button only changes the status bar
+    if (event->buttons() != Qt::NoButton)
+        update();
 }
 
 void DisplayWidget::mouseReleaseEvent(QMouseEvent* )
 {
+    // back to full quality
+    interactive = false;
+
     displaySettingsMgr.endCameraMovement();
     update();
 }
@@ -304,31 +494,6 @@ auto DisplayWidget::prevZoomLevel(float level) const -> float
     return std::ceil(r - 0.5f) / b;
 }
 
-auto DisplayWidget::makeShader(const char* vShaderSrc, const char* fShaderSrc) -> std::unique_ptr<QOpenGLShaderProgram>
-{
-    assert(vShaderSrc && "vShaderSrc must not be null!");
-    assert(fShaderSrc && "fShaderSrc must not be null!");
-    
-    auto shader = std::make_unique<QOpenGLShaderProgram>();
-
-    if (!shader->addShaderFromSourceCode(QOpenGLShader::Vertex, vShaderSrc))
-        throw OpenGLException{ "Failed to add vertex shader, error: " + shader->log() };
-    
-    if (!shader->addShaderFromSourceCode(QOpenGLShader::Fragment, fShaderSrc))
-        throw OpenGLException{ "Failed to add fragment shader, error: " + shader->log() };
-
-    shader->bindAttributeLocation("in_Position", vertexAttribLoc);
-    shader->bindAttributeLocation("in_TexCoords", texcoordAttribLoc);
-
-    if (!shader->link())
-        throw OpenGLException{ "Failed to link shader program!" };
-    
-    if (!shader->bind())
-        throw OpenGLException{ "Failed to bind shader program!" };
-
-    return shader;
-}
-
 void DisplayWidget::forEachLayer(const std::function<void(LayerBase*)>& func)
 {
     for (auto layer : std::array<LayerBase*, 3>{ frameLayer.get(), backgroundLayer.get(), upperLayer.get() })
@@ -339,108 +504,49 @@ void DisplayWidget::forEachLayer(const std::function<void(LayerBase*)>& func)
 auto DisplayWidget::layerAtPoint(const QPoint& point) const -> LayerBase*
 {
     for (const auto layer : std::array<LayerBase*, 2>{ upperLayer.get(), backgroundLayer.get() })
-    {
-        if (!layer)
-            continue;
-
-        const auto halfW = toInt(std::round((layer->getWidthF() * getZoom()) / 2.0f));
-        const auto halfH = toInt(std::round((layer->getHeightF() * getZoom()) / 2.0f));
-        const auto center = normalizedToPixel(layer->getTranslate());
-
-        const auto rot = QTransform()
-            .translate(qreal(center.x()), qreal(center.y()))
-            .rotate(-layer->getRotate())
-            .translate(-qreal(center.x()), -qreal(center.y()));
-
-        const auto rect = QRect{ QPoint{ center.x() - halfW, center.y() - halfH },
-                                 QPoint{ center.x() + halfW, center.y() + halfH }};
-
-        if (rot.mapToPolygon(rect).containsPoint(point, Qt::FillRule::OddEvenFill))
+        if (layer && layer->containsWinCoord(point))
             return layer;
-    }
 
     return nullptr;
 }
 
-void DisplayWidget::drawLayer(LayerBase& layer, const QMatrix4x4& matrix)
-{
-    if (!selectedShader->bind())
-        throw OpenGLException{ "Failed to bind shader program during drawLayer!" };
-
-    selectedShader->setUniformValue("matrix", matrix);
-    selectedShader->enableAttributeArray(vertexAttribLoc);
-    selectedShader->enableAttributeArray(texcoordAttribLoc);
-    selectedShader->setAttributeBuffer(vertexAttribLoc, GL_FLOAT, 0, 2, 4 * sizeof(GLfloat));
-    selectedShader->setAttributeBuffer(texcoordAttribLoc, GL_FLOAT, 2 * sizeof(GLfloat), 2, 4 * sizeof(GLfloat));
-
-    if (selectedShader == shaderProgram.get())
-    {
-        const auto colorData = mainWindow.getColorData();
-        selectedShader->setUniformValue("redLevel", colorData.red);
-        selectedShader->setUniformValue("greenLevel", colorData.green);
-        selectedShader->setUniformValue("blueLevel", colorData.blue);
-        selectedShader->setUniformValue("brightLevel", colorData.bright);
-        selectedShader->setUniformValue("contrastLevel", colorData.contrast);
-    }
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
-
-    layer.bindTexture();
-
-    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
-}
-
 void DisplayWidget::drawLayers()
 {
-    forEachLayer([this](LayerBase* layer) {
-        layer->bindVbo();
+    renderer->begin(mainWindow.getColorData(), grayscale);
 
-        auto projection = QMatrix4x4{};
-        projection.setToIdentity();
-        projection.ortho(-1.0f * getAspect(), getAspect(), -1.0f, +1.0f, -1.0f, +1.0f);
+    // the same for every layer, the layers' own matrices are cached by them
+    auto view = QMatrix4x4{};
+    view.ortho(-1.0f * getAspect(), getAspect(), -1.0f, +1.0f, -1.0f, +1.0f);
+    view.translate(displaySettingsMgr.getCameraTranslate());
 
-        auto transform = QMatrix4x4{};
-        transform.setToIdentity();
-        transform.translate(layer->getTranslate());
-        transform.translate(displaySettingsMgr.getCameraTranslate());
-        transform.rotate(layer->getRotate(), 0.0f, 0.0f, 1.0f);
-        transform.scale(layer->getScale());
-    
-        drawLayer(*layer, projection * transform);
+    forEachLayer([&](LayerBase* layer) {
+        // only the frame is drawn until there is something to show of the background
+        if (layer == backgroundLayer.get() && !backgroundLayer->isDisplayable())
+            return;
+
+        layer->draw(*renderer, view * layer->getModelMatrix());
     });
 }
 
+// a virtual texture only holds the tiles for the view, not the whole image at full resolution
 auto DisplayWidget::imageFromDisplay() -> std::optional<QImage>
 {
-    if (!backgroundLayer)
+    if (!backgroundLayer || backgroundLayer->isVirtual())
         return std::nullopt;
 
+    completeUpload();
     makeCurrent();
 
-    const auto width = frameLayer->getWidth();
-    const auto height = frameLayer->getHeight();
-    
-    glViewport(0, 0, width, height);
-    QOpenGLFramebufferObject framebuffer{ width, height, GL_TEXTURE_2D };
-
-    if (!framebuffer.bind())
-        throw OpenGLException{ "Failed to bind framebuffer!" };
-    
-    forEachLayer([this](LayerBase* layer) {
-        drawLayer(*layer);
+    const auto size = QSize{ frameLayer->getWidth(), frameLayer->getHeight() };
+    // the frame is drawn around the image on screen, it is not a part of it
+    auto img = renderer->render(size, mainWindow.getColorData(), grayscale, [this](const QMatrix4x4& matrix) {
+        forEachLayer([&](LayerBase* layer) {
+            if (layer != frameLayer.get())
+                layer->draw(*renderer, matrix);
+        });
     });
-    
-    const auto img = QImage{ framebuffer.toImage().mirrored() };
-
-    if (!framebuffer.release())
-        throw OpenGLException{ "Failed to release framebuffer!" };
-    
-    if (!framebuffer.bindDefault())
-        throw OpenGLException{ "Failed to rebind default framebuffer!" };
 
+    hud.setReadbackTime(renderer->getReadbackTime());
     doneCurrent();
 
     return img;
@@ -462,7 +568,30 @@ auto DisplayWidget::makeTexture(const QImage& image) -> util::owner_ptr<QOpenGLT
     auto p = util::make_owner<QOpenGLTexture>(image);
 
     p->setMagnificationFilter(QOpenGLTexture::Nearest);
-    p->setMinificationFilter(QOpenGLTexture::Nearest);
+    p->setMinificationFilter(minificationFilter);
+    p->setWrapMode(QOpenGLTexture::ClampToEdge);
+    trackTextureMemory(*p, true);
+
+    doneCurrent();
+    return p;
+}
+
+auto DisplayWidget::allocateTexture(const QSize& size) -> util::owner_ptr<QOpenGLTexture>
+{
+    makeCurrent();
+    auto p = util::make_owner<QOpenGLTexture>(QOpenGLTexture::Target2D);
+
+    p->setFormat(QOpenGLTexture::RGBA8_UNorm);
+    p->setSize(size.width(), size.height());
+    p->setMipLevels(p->maximumMipLevels());
+    p->allocateStorage(QOpenGLTexture::BGRA, QOpenGLTexture::UInt32_RGBA8_Rev);
+
+    // the levels above the first one are filled in later, see queueMipLevels
+    p->setMipMaxLevel(0);
+    p->setMagnificationFilter(QOpenGLTexture::Nearest);
+    p->setMinificationFilter(minificationFilter);
+    p->setWrapMode(QOpenGLTexture::ClampToEdge);
+    trackTextureMemory(*p, true);
 
     doneCurrent();
     return p;
@@ -471,6 +600,8 @@ auto DisplayWidget::makeTexture(const QImage& image) -> util::owner_ptr<QOpenGLT
 void DisplayWidget::deleteTexture(util::owner_ptr<QOpenGLTexture> texture)
 {
     makeCurrent();
+    if (texture)
+        trackTextureMemory(*texture, false);
     texture.reset();
     doneCurrent();
 }
@@ -496,7 +627,10 @@ void DisplayWidget::setOverlayColor(QRgb color)
     img.fill(color);
 
     if (UpperLayer::overlayTexture)
+    {
+        trackTextureMemory(*UpperLayer::overlayTexture, false);
         UpperLayer::overlayTexture.reset();
+    }
 
     UpperLayer::overlayTexture = makeTexture(img);
 }
@@ -514,8 +648,6 @@ auto DisplayWidget::zoomIn() -> std::optional<float>
 
     Logger::debug("Zoom in: " + QString::number(z));
 
-    update();
-
     return z;
 }
 
@@ -532,14 +664,87 @@ auto DisplayWidget::zoomOut() -> std::optional<float>
     Logger::debug("Zoom out: " + QString::number(z));
     Logger::debug("Width is " + QString::number(getWidth()) + " and height is " + QString::number(getHeight()));
 
-    update();
-
     return z;
 }
 
+// blocks until the background texture is complete, for the operations that read from it
+void DisplayWidget::completeUpload()
+{
+    if (!backgroundLayer || backgroundLayer->isUploaded())
+        return;
+
+    makeCurrent();
+    streamer->finish();
+    setBackgroundUploaded();
+    doneCurrent();
+}
+
+// expects the GL context to be current
+// the placeholder is not shown anymore, its texture is kept for stepping back to its image
+void DisplayWidget::setBackgroundUploaded()
+{
+    cacheTexture(placeholderKey, backgroundLayer->takePlaceholder());
+    backgroundLayer->setUploaded();
+}
+
+// an image is shown tile by tile if it does not fit into a texture, or if its texture would take too much of the
+// texture memory
+auto DisplayWidget::needsVirtualTexture(const QImage& img) const -> bool
+{
+    return img.width() > maxTextureSize || img.height() > maxTextureSize || img.sizeInBytes() >= virtualTextureMinBytes;
+}
+
+// expects the GL context to be current
+// a key of zero means that the texture does not hold a whole image, it is deleted then
+void DisplayWidget::cacheTexture(qint64 key, util::owner_ptr<QOpenGLTexture> texture)
+{
+    if (!texture)
+        return;
+
+    if (!textureCache || key == 0)
+    {
+        trackTextureMemory(*texture, false);
+        texture.reset();
+        return;
+    }
+
+    const auto bytes = textureBytes(*texture);
+    textureCache->insert(key, std::move(texture), bytes);
+}
+
+// the mip levels are generated outside of paintGL, between the events, and one at a time for large images,
+// so that neither the frame that completes an upload nor the input handling waits for all of them
+void DisplayWidget::queueMipLevels()
+{
+    if (mipLevelsQueued || !backgroundLayer || !backgroundLayer->hasPendingMipLevels())
+        return;
+
+    mipLevelsQueued = true;
+    QMetaObject::invokeMethod(this, [this] {
+        mipLevelsQueued = false;
+        if (!backgroundLayer || !backgroundLayer->hasPendingMipLevels())
+            return;
+
+        makeCurrent();
+        backgroundLayer->generateMipLevels();
+        doneCurrent();
+
+        if (backgroundLayer->hasPendingMipLevels())
+            queueMipLevels();
+        else
+            update();
+    }, Qt::QueuedConnection);
+}
+
+void DisplayWidget::trackTextureMemory(const QOpenGLTexture& texture, bool allocated)
+{
+    textureMemory += allocated ? textureBytes(texture) : -textureBytes(texture);
+    Logger::debug("Texture memory in use: " + QString::number(textureMemory / (1024 * 1024)) + " MiB");
+}
+
 void DisplayWidget::setGrayscale(bool grayscale)
 {
-    selectedShader = grayscale ? grayShaderProgram.get() : shaderProgram.get();
+    this->grayscale = grayscale;
 }
 
 void DisplayWidget::displayImage(const QImage& img)
@@ -547,7 +752,109 @@ void DisplayWidget::displayImage(const QImage& img)
     if (!frameLayer || img.width() != frameLayer->getWidth() || img.height() != frameLayer->getHeight())
         frameLayer.reset(new FrameLayer{ *this, img.width(), img.height() });
 
-    backgroundLayer.reset(new BackgroundLayer{ *this, img });
+    // the buffers still being filled with the previous image are not needed anymore
+    if (streamer)
+    {
+        makeCurrent();
+        streamer->cancel();
+        doneCurrent();
+    }
+
+    makeCurrent();
+
+    // the texture on screen, and the key of the image it holds, which is zero if it does not hold all of it
+    auto shown     = util::owner_ptr<QOpenGLTexture>{ nullptr };
+    auto shownKey  = qint64{ 0 };
+    auto shownSize = QSize{};
+    if (backgroundLayer)
+    {
+        shownKey  = backgroundLayer->hasPlaceholder() ? placeholderKey
+                  : backgroundLayer->isComplete()     ? backgroundLayer->getImageKey() : 0;
+        shownSize = backgroundLayer->getShownSize();
+        shown     = backgroundLayer->releaseShownTexture();
+    }
+
+    // a merged paste changes a few pixels of the image on screen, whose texture is kept, and only those are
+    // uploaded again, see BackgroundLayer::markDirty
+    const auto edited = pastedEdit && shownKey != 0 && shownKey == pastedEdit->baseKey &&
+                        pastedEdit->resultKey == img.cacheKey() && shownSize == img.size();
+    const auto editedRects = edited ? std::move(pastedEdit->rects) : std::vector<QRect>{};
+    pastedEdit.reset();
+
+    // undo and redo give back the images of the history, whose textures may still be cached, then they
+    // are only swapped; QImage::cacheKey is shared by the copies of an image until one of them is edited;
+    // an image that is shown tile by tile has no texture of its own
+    const auto tiled = needsVirtualTexture(img);
+    auto cached = util::owner_ptr<QOpenGLTexture>{ nullptr };
+    if (!tiled && shown && shownKey != 0 && shownKey == img.cacheKey())
+        cached = std::move(shown);
+    else if (!tiled && shown && edited)
+        cached = std::move(shown);
+    else if (!tiled && textureCache)
+        cached = textureCache->take(img.cacheKey());
+
+    // the previous image stays on screen until the new one is uploaded, drawn at its own size,
+    // and is cached afterwards, see setBackgroundUploaded
+    auto placeholder = util::owner_ptr<QOpenGLTexture>{ nullptr };
+    if (!tiled && !cached && shown)
+    {
+        placeholder    = std::move(shown);
+        placeholderKey = shownKey;
+    }
+    else
+    {
+        cacheTexture(shownKey, std::move(shown));
+    }
+
+    // the tiles are loaded while the image is drawn, the coarsest one right away
+    auto virtualTexture = std::unique_ptr<VirtualTexture>{ nullptr };
+    if (tiled)
+    {
+        // showing the same image again does not build its levels again, which takes a while for a large one
+        if (!pyramid || pyramidKey != img.cacheKey())
+        {
+            pyramid    = std::make_shared<const TilePyramid>(img, VirtualTexture::tileSize);
+            pyramidKey = img.cacheKey();
+        }
+
+        virtualTexture = std::make_unique<VirtualTexture>(pyramid, maxTextureSize);
+        trackTextureMemory(virtualTexture->getAtlas(), true);
+    }
+    else
+    {
+        // the coarser levels take a third of the memory of the image, they are not kept for later
+        pyramid.reset();
+    }
+
+    doneCurrent();
+
+    if (virtualTexture)
+    {
+        backgroundLayer.reset(new BackgroundLayer{ *this, img, std::move(virtualTexture) });
+    }
+    else if (cached)
+    {
+        const auto mipLevelsReady = cached->mipMaxLevel();
+        backgroundLayer.reset(new BackgroundLayer{ *this, img, std::move(cached), mipLevelsReady });
+
+        for (const auto& rect : editedRects)
+            backgroundLayer->markDirty(rect);
+    }
+    else
+    {
+        backgroundLayer.reset(new BackgroundLayer{ *this, img, std::move(placeholder), shownSize });
+
+        if (streamer)
+        {
+            makeCurrent();
+            streamer->start(backgroundLayer->getUploadTarget(), img);
+            doneCurrent();
+        }
+        else
+        {
+            backgroundLayer->uploadOnBind();
+        }
+    }
 
     upperLayer.reset();
 
@@ -572,8 +879,8 @@ auto DisplayWidget::mergeLayers() -> QImage
         auto emptyImg = QImage{ lower.size(), lower.format() };
         emptyImg.fill(Qt::black);
 
-        return mainWindow.mergeImages(emptyImg, lower, frameLayer->layerRectFromWinRect(backgroundLayer->getWinRect()),
-                                      backgroundLayer->getRotate());
+        return timedMerge(emptyImg, lower, frameLayer->layerRectFromWinRect(backgroundLayer->getWinRect()),
+                          backgroundLayer->getRotate());
     }
     else if (upperLayer && !upperLayer->inSelectMode())
     {
@@ -583,8 +890,28 @@ auto DisplayWidget::mergeLayers() -> QImage
         Logger::debug("upperWinRect is " + util::toQString(upperLayer->getWinRect()) +
                       ", and frameUpperRect is " + util::toQString(layerUpperRect));
             
-        return mainWindow.mergeImages(backgroundLayer->getImage(), *upperLayer->getImage(), layerUpperRect,
-                                      upperLayer->getRotate());
+        auto merged = timedMerge(backgroundLayer->getImage(), *upperLayer->getImage(), layerUpperRect, upperLayer->getRotate());
+
+        // the merge only writes the pixels the rotated upper rectangle covers, give or take one for the rounding,
+        // and the background differs from its texture only where it was cut from
+        const auto center = QRectF{ layerUpperRect }.center();
+        auto transform = QTransform{};
+        transform.translate(center.x(), center.y()).rotate(toDouble(upperLayer->getRotate())).translate(-center.x(), -center.y());
+
+        const auto pastedRect = transform.mapRect(QRectF{ layerUpperRect }).toAlignedRect().adjusted(-1, -1, 1, 1);
+        pastedEdit = PastedEdit{ backgroundLayer->getImageKey(), merged.cacheKey(), { pastedRect, backgroundLayer->getErasedArea() } };
+
+        return merged;
+    }
+
+    // the colors are baked on the CPU, unless the merge backend is the GPU
+    auto timer = QElapsedTimer{};
+    timer.start();
+
+    if (auto adjusted = mainWindow.adjustColors(backgroundLayer->getImage(), grayscale, !backgroundLayer->isVirtual()))
+    {
+        hud.setMergeTime(toDouble(timer.nsecsElapsed()) / 1e6);
+        return *adjusted;
     }
 
     auto opt = imageFromDisplay();
@@ -594,6 +921,17 @@ auto DisplayWidget::mergeLayers() -> QImage
     return backgroundLayer->getImage();
 }
 
+auto DisplayWidget::timedMerge(const QImage& lower, const QImage& upper, const QRect& upperRect, float upperAngle) -> QImage
+{
+    auto timer = QElapsedTimer{};
+    timer.start();
+
+    auto merged = mainWindow.mergeImages(lower, upper, upperRect, upperAngle);
+    hud.setMergeTime(toDouble(timer.nsecsElapsed()) / 1e6);
+
+    return merged;
+}
+
 auto DisplayWidget::revertChanges() -> bool
 {
     if (!backgroundLayer)
@@ -602,7 +940,7 @@ auto DisplayWidget::revertChanges() -> bool
     if (upperLayer)
     {
         if (!upperLayer->inSelectMode() && upperLayer->getCutData())
-            backgroundLayer->fillArea(*upperLayer->getCutData());
+            backgroundLayer->restoreErasedArea();
 
         upperLayer.reset();
     }
@@ -624,6 +962,15 @@ auto DisplayWidget::copy() -> bool
     if (!backgroundLayer || !upperLayer)
         return false;
 
+    // the copy is drawn from the background texture, of which a virtual texture only holds the tiles in view
+    if (backgroundLayer->isVirtual())
+    {
+        Logger::warning("Copying is not supported for images that are shown tile by tile");
+        return false;
+    }
+
+    completeUpload();
+
     // calculate the texture coordinates based on the selection rect's corners, and create a VBO from it
     const auto zoomedLowerRect  = backgroundLayer->getZoomedWinRect();
     const auto zoomedUpperRect  = upperLayer->getZoomedWinRect();
@@ -663,6 +1010,15 @@ auto DisplayWidget::cut() -> bool
     if (!backgroundLayer || !upperLayer || upperLayer->getCutData())
         return false;
 
+    // the cut is drawn from the background texture, like a copy
+    if (backgroundLayer->isVirtual())
+    {
+        Logger::warning("Cutting is not supported for images that are shown tile by tile");
+        return false;
+    }
+
+    completeUpload();
+
     // specify the intersected part of the lower image
     const auto layerLowerRect  = frameLayer->layerRectFromWinRect(backgroundLayer->getWinRect());
     const auto layerUpperRect  = frameLayer->layerRectFromWinRect(upperLayer->getWinRect());
@@ -674,9 +1030,8 @@ auto DisplayWidget::cut() -> bool
 
     const auto img = mainWindow.getImage()->copy(layerSelectRect);
 
-    upperLayer->setCutData(*this, img, layerSelectRect, makeTexture(img));
-
-    // paint the copied area to a default background color
+    // neither a texture is made for the cut, nor is the background uploaded again
+    upperLayer->setCutData(layerSelectRect, img, makeSourceVbo(layerSelectRect), &backgroundLayer->getTexture());
     backgroundLayer->eraseArea(layerSelectRect);
 
     upperLayer->setSelectSize(layerSelectRect.size());
@@ -699,3 +1054,87 @@ auto DisplayWidget::rotate(float angle) -> bool
 
     return true;
 }
+
+auto DisplayWidget::getLayerState() const -> std::optional<LayerState>
+{
+    if (!upperLayer || upperLayer->inSelectMode())
+        return std::nullopt;
+
+    auto state = LayerState{};
+    if (const auto cutData = upperLayer->getCutData())
+    {
+        state.kind           = LayerState::CUT;
+        state.image          = cutData->image;
+        state.sourcePosition = cutData->sourcePosition;
+    }
+    else
+    {
+        state.kind           = LayerState::COPY;
+        state.image          = upperLayer->getCopyData()->image;
+        state.sourcePosition = upperLayer->getCopyData()->sourcePosition;
+    }
+
+    state.translate = upperLayer->getTranslate() / getZoom();
+    state.rotate    = upperLayer->getRotate();
+
+    return state;
+}
+
+auto DisplayWidget::restoreLayerState(const LayerState& state) -> bool
+{
+    if (!backgroundLayer)
+        return false;
+
+    if (!QRect{ 0, 0, backgroundLayer->getWidth(), backgroundLayer->getHeight() }.contains(state.sourcePosition))
+        return false;
+
+    if (backgroundLayer->isVirtual())
+    {
+        Logger::warning("Can not restore a copied or cut area of an image that is shown tile by tile");
+        return false;
+    }
+
+    completeUpload();
+
+    upperLayer.reset();
+    upperLayer = util::make_owner<UpperLayer>(*this);
+
+    // the copied or cut area is sampled from the background texture, like in copy() and cut()
+    const auto vbo = makeSourceVbo(state.sourcePosition);
+
+    if (state.kind == LayerState::CUT)
+    {
+        upperLayer->setCutData(state.sourcePosition, state.image, vbo, &backgroundLayer->getTexture());
+        backgroundLayer->eraseArea(state.sourcePosition);
+    }
+    else
+    {
+        upperLayer->setCopyData(state.sourcePosition, state.image, vbo, &backgroundLayer->getTexture());
+    }
+
+    upperLayer->setSelectSize(state.sourcePosition.size());
+    upperLayer->translateTo(state.translate * getZoom());
+    upperLayer->rotateTo(state.rotate);
+
+    selectedLayer = upperLayer.get();
+
+    update();
+
+    return true;
+}
+
+// the quad's texture coordinates cover exactly the rect of the background image
+auto DisplayWidget::makeSourceVbo(const QRect& rect) -> std::shared_ptr<VertexBuffer>
+{
+    const auto left   = toFloat(rect.left()) / backgroundLayer->getWidthF();
+    const auto right  = toFloat(rect.left() + rect.width()) / backgroundLayer->getWidthF();
+    const auto bottom = toFloat(rect.top()) / backgroundLayer->getHeightF();
+    const auto top    = toFloat(rect.top() + rect.height()) / backgroundLayer->getHeightF();
+
+    makeCurrent();
+    auto vbo = VertexBuffer::make({ QPointF{ left, bottom }, QPointF{ right, bottom },
+                                    QPointF{ right, top }, QPointF{ left, top } });
+    doneCurrent();
+
+    return vbo;
+}
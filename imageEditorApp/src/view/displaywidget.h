@@ -1,19 +1,29 @@
 #pragma once
 
+#include <colordata.h>
 #include "coordconverter.h"
 #include "displaysettingsmanager.h"
+#include "framestats.h"
 #include "idisplay.h"
 #include "imainwindow.h"
 #include "layer.h"
+#include "performancehud.h"
+#include <projectdata.h>
+#include <renderer.h>
+#include <texturecache.h>
+#include "texturestreamer.h"
+#include <tilepyramid.h>
 #include <util.h>
-#include "vertexbuffer.h"
+#include <vertexbuffer.h>
 
 #include <memory>
 #include <optional>
 #include <vector>
 #include <QOpenGLWidget>
 #include <QOpenGLFunctions>
-#include <QOpenGLShaderProgram>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLTexture>
+#include <QTimer>
 
 using namespace util::types;
 
@@ -41,12 +51,16 @@ public:
     auto zoomOut() -> std::optional<float>;
 
     void setGrayscale(bool grayscale);
+    auto isHudEnabled() const -> bool { return hud.isEnabled(); }
+    void setHudEnabled(bool enable);
     void displayImage(const QImage& img);
     auto mergeLayers() -> QImage;
     auto revertChanges() -> bool;
     auto copy() -> bool;
     auto cut() -> bool;
     auto rotate(float angle = 0.0f) -> bool;
+    auto getLayerState() const -> std::optional<LayerState>;
+    auto restoreLayerState(const LayerState& state) -> bool;
 
 signals:
     void zoomChanged(float zoom);
@@ -55,29 +69,55 @@ signals:
     void actionStarted();
 
 private:
-    static const char* const vertexShaderSource;
-    static const char* const fragmentShaderSource;
-    static const char* const grayscaleFragmentShaderSource;
     static const uint        defaultGray;
-    static const int         vertexAttribLoc;
-    static const int         texcoordAttribLoc;
     static const float       zoomStep;
+    static const int         previewDownscale;
+    static const qint64      previewMinImagePixels;
+    static const int         previewGranularity;
+    static const int         resizeSettleTime;     // in ms
+    static const qint64      textureCacheBudget;   // in bytes
+    static const qint64      virtualTextureMinBytes;
+    static const int         fallbackMaxTextureSize;
+    static const QOpenGLTexture::Filter minificationFilter;
+
+    // what a merged paste changed, so that the merged image keeps the texture of the one it was pasted on
+    struct PastedEdit
+    {
+        qint64             baseKey;      // of the background the paste was merged into
+        qint64             resultKey;    // of the merged image
+        std::vector<QRect> rects;
+    };
 
     IMainWindow&                          mainWindow;
+    QTimer* const                         resizeTimer;
     
-    std::unique_ptr<QOpenGLShaderProgram> shaderProgram{ nullptr };
-    std::unique_ptr<QOpenGLShaderProgram> grayShaderProgram{ nullptr };
-    QOpenGLShaderProgram*                 selectedShader{ nullptr };
+    bool                                  grayscale{ false };
     
     util::owner_ptr<FrameLayer>           frameLayer{ nullptr };
     util::owner_ptr<BackgroundLayer>      backgroundLayer{ nullptr };
     util::owner_ptr<UpperLayer>           upperLayer{ nullptr };
     LayerBase*                            selectedLayer{ nullptr };
+    std::unique_ptr<TextureStreamer>      streamer{ nullptr };
+    std::unique_ptr<Renderer>             renderer{ nullptr };
+    std::unique_ptr<TextureCache>         textureCache{ nullptr };
+    qint64                                placeholderKey{ 0 };      // of the image the background's placeholder holds
+    std::unique_ptr<FrameStats>           frameStats{ nullptr };
+    PerformanceHud                        hud;
+    bool                                  mipLevelsQueued{ false };
+    bool                                  interactive{ false };     // a mouse button is held on the display
+    bool                                  resizing{ false };        // the size has changed within resizeSettleTime
+    std::unique_ptr<QOpenGLFramebufferObject> previewFramebuffer{ nullptr };
+    qint64                                textureMemory{ 0 };
+    int                                   maxTextureSize;           // queried again once the GL context is initialized
+    std::shared_ptr<const TilePyramid>    pyramid{ nullptr };       // of the image shown tile by tile
+    qint64                                pyramidKey{ 0 };          // the cache key of that image
+    std::optional<PastedEdit>             pastedEdit;               // of the last merge, see displayImage
 
     DisplaySettingsManager                displaySettingsMgr;
 
     // inherited via QOpenGLWidget
     virtual void initializeGL() override;
+    virtual void resizeGL(int w, int h) override;
     virtual void paintGL() override;
     virtual void mousePressEvent(QMouseEvent* event) override;
     virtual void mouseMoveEvent(QMouseEvent* event) override;
@@ -94,6 +134,7 @@ private:
     virtual auto pixelToNormalized(const QPoint& pixel) const -> QVector3D override;
     virtual auto normalizedToPixel(const QVector3D& norm) const -> QPoint override;
     virtual auto makeTexture(const QImage& image) -> util::owner_ptr<QOpenGLTexture> override;
+    virtual auto allocateTexture(const QSize& size) -> util::owner_ptr<QOpenGLTexture> override;
     virtual void deleteTexture(util::owner_ptr<QOpenGLTexture> texture) override;
 
     auto toPixelCoord(const QPoint& p) -> QPoint;
@@ -103,11 +144,21 @@ private:
     auto nextZoomLevel(float level) const -> float;
     auto prevZoomLevel(float level) const -> float;
 
-    auto makeShader(const char* vShaderSrc, const char* fShaderSrc) -> std::unique_ptr<QOpenGLShaderProgram>;
-    
     void forEachLayer(const std::function<void(LayerBase*)>& func);
     auto layerAtPoint(const QPoint& point) const -> LayerBase*;
-    void drawLayer(LayerBase& layer, const QMatrix4x4& matrix = {});
     void drawLayers();
     auto imageFromDisplay() -> std::optional<QImage>;
+    auto makeSourceVbo(const QRect& rect) -> std::shared_ptr<VertexBuffer>;
+    auto timedMerge(const QImage& lower, const QImage& upper, const QRect& upperRect, float upperAngle) -> QImage;
+    void completeUpload();
+    void setBackgroundUploaded();
+    auto needsVirtualTexture(const QImage& img) const -> bool;
+    void cacheTexture(qint64 key, util::owner_ptr<QOpenGLTexture> texture);
+    void setGLOptions();
+    auto beginPreview() -> bool;
+    void endPreview();
+    auto deviceSize() const -> QSize;
+    auto previewSize() const -> QSize;
+    void queueMipLevels();
+    void trackTextureMemory(const QOpenGLTexture& texture, bool allocated);
 };
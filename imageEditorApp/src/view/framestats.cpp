@@ -0,0 +1,135 @@
+#include "framestats.h"
+#include <logger.h>
+#include <util.h>
+
+#include <algorithm>
+#include <vector>
+
+using namespace util::types;
+
+const int         FrameStats::reportInterval{ 120 };
+const std::size_t FrameStats::historySize{ 240 };
+
+namespace
+{
+    auto toMilliseconds(qint64 nanoseconds) -> double
+    {
+        return toDouble(nanoseconds) / 1e6;
+    }
+
+    auto format(double milliseconds) -> QString
+    {
+        return QString::number(milliseconds, 'f', 2) + " ms";
+    }
+}
+
+FrameStats::FrameStats()
+{
+    clock.start();
+
+    for (auto& q : queries)
+    {
+        q.query = std::make_unique<QOpenGLTimerQuery>();
+        if (!q.query->create())
+        {
+            hasQueries = false;
+            Logger::debug("Timer queries are not supported, only the CPU time of the frames is measured");
+            break;
+        }
+    }
+}
+
+void FrameStats::begin()
+{
+    timer.start();
+    history.push_back({ clock.elapsed(), 0.0, 0 });
+    if (history.size() > historySize)
+        history.pop_front();
+
+    collect();
+
+    // if every query is still in flight, this frame is not measured on the GPU
+    auto& q = queries[nextQuery];
+    if (hasQueries && !q.pending)
+    {
+        q.query->begin();
+        activeQuery = &q;
+    }
+}
+
+void FrameStats::end(int uniformUpdates, qint64 uploadedBytes)
+{
+    if (activeQuery)
+    {
+        activeQuery->query->end();
+        activeQuery->pending = true;
+        activeQuery = nullptr;
+        nextQuery = (nextQuery + 1) % queries.size();
+    }
+
+    cpuTime = toMilliseconds(timer.nsecsElapsed());
+    history.back().cpuTime       = cpuTime;
+    history.back().uploadedBytes = uploadedBytes;
+
+    ++totals.frames;
+    totals.uniformUpdates += uniformUpdates;
+    totals.uploadedBytes  += uploadedBytes;
+    totals.cpuTime += cpuTime;
+    totals.cpuMax = std::max(totals.cpuMax, cpuTime);
+
+    if (totals.frames == reportInterval)
+        report();
+}
+
+auto FrameStats::getFps() const -> int
+{
+    const auto since = clock.elapsed() - 1000;
+    return toInt(std::count_if(history.begin(), history.end(), [since](const Frame& f) { return f.start >= since; }));
+}
+
+auto FrameStats::getCpuPercentile(double p) const -> double
+{
+    if (history.empty())
+        return 0.0;
+
+    auto times = std::vector<double>(history.size());
+    std::transform(history.begin(), history.end(), times.begin(), [](const Frame& f) { return f.cpuTime; });
+
+    const auto nth = times.begin() + std::ptrdiff_t(std::clamp(p, 0.0, 1.0) * toDouble(times.size() - 1) + 0.5);
+    std::nth_element(times.begin(), nth, times.end());
+
+    return *nth;
+}
+
+void FrameStats::collect()
+{
+    for (auto& q : queries)
+    {
+        if (!q.pending || !q.query->isResultAvailable())
+            continue;
+
+        // the result is available, so this does not wait
+        const auto time = toMilliseconds(qint64(q.query->waitForResult()));
+        q.pending = false;
+
+        gpuTime = time;
+        ++totals.gpuFrames;
+        totals.gpuTime += time;
+        totals.gpuMax = std::max(totals.gpuMax, time);
+    }
+}
+
+void FrameStats::report()
+{
+    auto msg = "Frame times over " + QString::number(totals.frames) + " frames: CPU " +
+               format(totals.cpuTime / totals.frames) + " average, " + format(totals.cpuMax) + " max";
+
+    if (totals.gpuFrames > 0)
+        msg += "; GPU " + format(totals.gpuTime / totals.gpuFrames) + " average, " + format(totals.gpuMax) + " max";
+
+    msg += "; " + QString::number(toDouble(totals.uniformUpdates) / totals.frames, 'f', 1) + " uniform updates and " +
+           QString::number(totals.uploadedBytes / totals.frames / 1024) + " KiB uploaded per frame";
+
+    Logger::debug(msg);
+    totals = {};
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <QElapsedTimer>
+#include <QOpenGLTimerQuery>
+
+// FrameStats: Measures how long each frame takes on the CPU, and on the GPU if timer queries are supported
+//             (GL 3.3 or ARB_timer_query). The queries rotate through a small ring and their results are only
+//             collected once they are available, a few frames later, so measuring never stalls the pipeline.
+//             The averages and maxima are logged every reportInterval frames, together with the number of
+//             uniform values and texture bytes that were sent. The last historySize frames are kept for the
+//             performance overlay. Every function expects the GL context to be current.
+class FrameStats
+{
+public:
+    static const int         reportInterval;
+    static const std::size_t historySize;
+
+    FrameStats();
+
+    FrameStats(const FrameStats&) = delete;
+    FrameStats& operator=(const FrameStats&) = delete;
+
+    void begin();
+    void end(int uniformUpdates, qint64 uploadedBytes);
+
+    // of the last frame, in milliseconds
+    auto getCpuTime() const -> double                 { return cpuTime; }
+    auto getGpuTime() const -> std::optional<double>  { return gpuTime; }
+    auto getUploadedBytes() const -> qint64           { return history.empty() ? 0 : history.back().uploadedBytes; }
+
+    // the frames drawn during the last second, the display only repaints when something changed
+    auto getFps() const -> int;
+
+    // p is in [0, 1], over the CPU times of the frames in the history
+    auto getCpuPercentile(double p) const -> double;
+
+private:
+    struct Query
+    {
+        std::unique_ptr<QOpenGLTimerQuery> query{ nullptr };
+        bool                               pending{ false };
+    };
+
+    struct Frame
+    {
+        qint64 start{ 0 };      // in milliseconds since the construction
+        double cpuTime{ 0.0 };
+        qint64 uploadedBytes{ 0 };
+    };
+
+    struct Totals
+    {
+        int    frames{ 0 };
+        int    gpuFrames{ 0 };
+        int    uniformUpdates{ 0 };
+        qint64 uploadedBytes{ 0 };
+        double cpuTime{ 0.0 };
+        double cpuMax{ 0.0 };
+        double gpuTime{ 0.0 };
+        double gpuMax{ 0.0 };
+    };
+
+    std::array<Query, 4>  queries;
+    std::size_t           nextQuery{ 0 };
+    Query*                activeQuery{ nullptr };
+    bool                  hasQueries{ true };
+    QElapsedTimer         timer;
+    QElapsedTimer         clock;
+    std::deque<Frame>     history;
+    double                cpuTime{ 0.0 };
+    std::optional<double> gpuTime;
+    Totals                totals;
+
+    void collect();
+    void report();
+};
@@ -38,6 +38,8 @@ KeybindingsDialog::KeybindingsDialog(QWidget* parent)
     
     const auto keybindings = std::vector<std::pair<QString, QString>> {
         { "Ctrl + O"    , "Open" },
+        { "Page Down"   , "Next image of the directory" },
+        { "Page Up"     , "Previous image of the directory" },
         { "Ctrl + S"    , "Save" },
         { "Ctrl + Q"    , "Quit" },
         { "Ctrl + N"    , "Zoom In" },
@@ -52,7 +54,8 @@ KeybindingsDialog::KeybindingsDialog(QWidget* parent)
         { "Ctrl + Left" , "Rotate left by 90 degrees" },
         { "Ctrl + Right", "Rotate right by 90 degrees" },
         { "Ctrl + Down" , "Rotate by 180 degrees" },
-        { "Ctrl + Up"   , "Reset rotation" }
+        { "Ctrl + Up"   , "Reset rotation" },
+        { "F12"         , "Show or hide the performance overlay" }
     };
 
     tableWidget = new QTableWidget{ toInt(keybindings.size()), 2, this };
@@ -4,6 +4,7 @@
 
 class QOpenGLTexture;
 class QPoint;
+class QSize;
 class QVector3D;
 
 class IDisplay
@@ -20,5 +21,6 @@ public:
     virtual auto pixelToNormalized(const QPoint& pixel) const -> QVector3D = 0;
     virtual auto normalizedToPixel(const QVector3D& norm) const -> QPoint = 0;
     virtual auto makeTexture(const QImage& image) -> util::owner_ptr<QOpenGLTexture> = 0;
+    virtual auto allocateTexture(const QSize& size) -> util::owner_ptr<QOpenGLTexture> = 0;
     virtual void deleteTexture(util::owner_ptr<QOpenGLTexture> texture) = 0;
 };
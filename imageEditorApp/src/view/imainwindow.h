@@ -1,7 +1,8 @@
 #pragma once
 
-#include "colordata.h"
+#include <colordata.h>
 
+#include <optional>
 #include <QImage>
 
 class IMainWindow
@@ -12,4 +13,8 @@ public:
     virtual auto getImage() -> std::optional<QImage> = 0;
     virtual auto getColorData() -> ColorData = 0;
     virtual auto mergeImages(QImage lower, QImage upper, QRect upperRect, float upperAngle) -> QImage = 0;
+
+    // the image with the color data applied, or in grayscale; nothing if the display should render it,
+    // which it can not for an image it only shows tile by tile
+    virtual auto adjustColors(const QImage& image, bool grayscale, bool renderable) -> std::optional<QImage> = 0;
 };
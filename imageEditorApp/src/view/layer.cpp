@@ -9,12 +9,13 @@
 #include <QOpenGLTexture>
 #include <QOpenGLPixelTransferOptions>
 #include <QPainter>
+#include <QTransform>
 #include <QVector3D>
 
 std::shared_ptr<VertexBuffer>   LayerBase::defaultVbo{ nullptr };
 const float                     LayerBase::defaultScale{ 0.75f };
 util::owner_ptr<QOpenGLTexture> UpperLayer::overlayTexture{ nullptr };
-const QRgb                      FrameLayer::borderColor{ qRgba(0x80, 0x80, 0x80, 0x00) };
+const qsizetype                 BackgroundLayer::incrementalMipBytes{ 64 * 1024 * 1024 };
 
 auto LayerBase::layerRectFromWinRect(const QRect& winrect) const -> QRect
 {
@@ -28,13 +29,7 @@ auto LayerBase::layerCoordFromWinCoord(const QPoint& wincoord) const -> QPoint
 
     // apply a reverse transformation to this vector to obtain the original normalized
     // coordinates, as if the layer's corners were the same as the corners of the display
-    const auto scaleVec = getScale();
-    auto revtrans = QMatrix4x4{};
-    revtrans.scale(1.0f / scaleVec.x(), 1.0f/ scaleVec.y());
-    revtrans.rotate(-rotateDelta, 0.0f, 0.0f, 1.0f);
-    revtrans.translate(-getTranslate().x(), -getTranslate().y());
-
-    const auto revnormvec = revtrans * normvec;
+    const auto revnormvec = getInverseMatrix() * normvec;
 
     // the size of one pixel in the normalized coordinate system
     const auto sx = 2.0f / getWidthF();
@@ -47,6 +42,13 @@ auto LayerBase::layerCoordFromWinCoord(const QPoint& wincoord) const -> QPoint
     return { x, y };
 }
 
+// the layer covers [-1, 1] in both directions before its transformation
+auto LayerBase::containsWinCoord(const QPoint& wincoord) const -> bool
+{
+    const auto revnormvec = getInverseMatrix() * display.pixelToNormalized(wincoord);
+    return std::abs(revnormvec.x()) <= 1.0f && std::abs(revnormvec.y()) <= 1.0f;
+}
+
 auto LayerBase::texCoordFromWinCoord(const QPoint& winCoord) const -> QPointF
 {
     const auto v = layerCoordFromWinCoord(winCoord);
@@ -79,6 +81,42 @@ auto LayerBase::getZoomedWinRect() const -> QRect
             util::round(getHeightF() * zoom) }};
 }
 
+auto LayerBase::getTransforms() const -> const Transforms&
+{
+    const auto zoom        = display.getZoom();
+    const auto displaySize = QSize{ display.getWidth(), display.getHeight() };
+
+    if (transforms.valid && transforms.zoom == zoom && transforms.displaySize == displaySize)
+        return transforms;
+
+    const auto scale     = getScale();
+    const auto translate = getTranslate();
+
+    transforms.model.setToIdentity();
+    transforms.model.translate(translate);
+    transforms.model.rotate(getRotate(), 0.0f, 0.0f, 1.0f);
+    transforms.model.scale(scale);
+
+    // undoes the translation and the scale, the rotation keeps the sign the window coordinates have always used
+    transforms.inverse.setToIdentity();
+    transforms.inverse.scale(1.0f / scale.x(), 1.0f / scale.y());
+    transforms.inverse.rotate(-rotateDelta, 0.0f, 0.0f, 1.0f);
+    transforms.inverse.translate(-translate.x(), -translate.y());
+
+    transforms.zoom        = zoom;
+    transforms.displaySize = displaySize;
+    transforms.valid       = true;
+
+    return transforms;
+}
+
+void TexturedLayer::draw(Renderer& renderer, const QMatrix4x4& matrix)
+{
+    bindVbo();
+    bindTexture();
+    renderer.draw(matrix);
+}
+
 auto UpperLayer::getScale() const -> QVector3D
 {
     const auto v = QVector3D{ getWidthF(), getHeightF(), 0.0f };
@@ -108,65 +146,214 @@ void UpperLayer::setCopyData(const QRect& sourcePosition, QImage image,
     copyData = std::make_unique<CopyData>(image, sourcePosition);
 }
 
-void UpperLayer::setCutData(IDisplay& display, const QImage& image,
-                            const QRect& sourcePosition, util::owner_ptr<QOpenGLTexture> texture)
+void UpperLayer::setCutData(const QRect& sourcePosition, QImage image,
+                            std::shared_ptr<VertexBuffer> vbo, QOpenGLTexture* texture)
 {
-    this->texture = texture.get();
-    cutData = std::make_unique<CutData>(display, image, sourcePosition, std::move(texture));
+    if (!texture)
+    {
+        Logger::error("Tried to set upperLayer cut texture with a null pointer!");
+        return;
+    }
+
+    this->vbo = vbo;
+    this->texture = texture;
+    cutData = std::make_unique<CutData>(image, sourcePosition);
 }
 
+// the placeholder keeps the geometry of its own image, which may differ from the new one's
 auto BackgroundLayer::getScale() const -> QVector3D
 {
-    const auto visibleHeightRatio = (getHeightF() * display.getZoom()) / display.getHeightF();
-    return { getAspect() * visibleHeightRatio, visibleHeightRatio, 0.0f };
+    const auto size = getShownSize();
+    const auto visibleHeightRatio = (toFloat(size.height()) * display.getZoom()) / display.getHeightF();
+    return { toFloat(size.width()) / toFloat(size.height()) * visibleHeightRatio, visibleHeightRatio, 0.0f };
 }
 
-// TODO: loading textures this way may not be portable; should find a portable way of dealing
-//       with pixel byte order and endianness
-// TODO: put transparent pixels into a large static buffer, and send texture data from there
-// TODO: fix setData instead of creating a new texture
-void BackgroundLayer::eraseArea(const QRect& rect)
+BackgroundLayer::~BackgroundLayer()
 {
-    const auto black = qRgba(0x00, 0x00, 0x00, 0xff);
-    const auto buf = std::vector<QRgb>(std::size_t(rect.width() * rect.height()), black);
+    display.deleteTexture(std::move(texture));
+    display.deleteTexture(std::move(placeholder));
 
-    auto painter = QPainter{ &image };
-    painter.setBackground(QBrush{ black });
-    painter.setBackgroundMode(Qt::OpaqueMode);
-    painter.eraseRect(rect);
+    if (virtualTexture)
+        display.deleteTexture(virtualTexture->releaseAtlas());
+}
+
+auto BackgroundLayer::getTexture() -> QOpenGLTexture&
+{
+    return virtualTexture ? virtualTexture->getAtlas() : placeholder ? *placeholder : *texture;
+}
+
+auto BackgroundLayer::getTexture() const -> const QOpenGLTexture&
+{
+    return virtualTexture ? virtualTexture->getAtlas() : placeholder ? *placeholder : *texture;
+}
+
+// the edits made while the texture is streamed are uploaded once it is complete,
+// since the slices still to come would overwrite them otherwise
+void BackgroundLayer::bindTexture()
+{
+    if (uploaded)
+        uploadDirtyRegion();
+
+    getTexture().bind();
+}
+
+// expects the GL context to be current
+void BackgroundLayer::setUploaded()
+{
+    uploaded = true;
+    placeholder.reset();
+    invalidateTransforms();
+}
+
+// used when the texture can not be streamed, the whole image is uploaded the next time it is bound
+void BackgroundLayer::uploadOnBind()
+{
+    markDirty(image.rect());
+    uploaded = true;
+}
+
+// the texture holds exactly the image, with none of its edits waiting to be uploaded
+auto BackgroundLayer::isComplete() const -> bool
+{
+    return uploaded && !placeholder && dirtyRegion.isEmpty();
+}
+
+// the texture that is on screen, so that the next background can show it until its own is complete
+auto BackgroundLayer::releaseShownTexture() -> util::owner_ptr<QOpenGLTexture>
+{
+    return placeholder ? std::move(placeholder) : uploaded ? std::move(texture) : nullptr;
+}
 
-    texture.reset();
-    texture = display.makeTexture(image);
-    // texture->setData(rect.left(), rect.top(), 0,
-    //                  rect.width(), rect.height(), 0,
-    //                  QOpenGLTexture::PixelFormat::BGRA, QOpenGLTexture::UInt32_RGBA8_Rev, buf.data());
+auto BackgroundLayer::takeUploadedBytes() -> qint64
+{
+    const auto bytes = uploadedBytes + (virtualTexture ? virtualTexture->takeUploadedBytes() : 0);
+    uploadedBytes = 0;
+
+    return bytes;
+}
+
+// the atlas has no mip levels, the tiles come from the level of the pyramid that fits the zoom
+auto BackgroundLayer::hasPendingMipLevels() const -> bool
+{
+    return !virtualTexture && uploaded && !placeholder && mipLevelsReady < texture->mipLevels() - 1;
+}
+
+auto BackgroundLayer::hasPendingTiles() const -> bool
+{
+    return virtualTexture && virtualTexture->hasPendingTiles();
+}
+
+auto BackgroundLayer::getTileStats() const -> std::optional<CacheStats>
+{
+    return virtualTexture ? std::make_optional(virtualTexture->stats()) : std::nullopt;
+}
+
+// expects the GL context to be current
+// one level per call for large images, so that generating them is spread over several event loop iterations,
+// meanwhile the texture is sampled from the levels that are ready
+void BackgroundLayer::generateMipLevels()
+{
+    const auto last = image.sizeInBytes() > incrementalMipBytes ? mipLevelsReady + 1 : texture->mipLevels() - 1;
+
+    texture->setMipMaxLevel(last);
+    texture->generateMipMaps(mipLevelsReady, true);
+    mipLevelsReady = last;
+}
+
+// the erased area is given to the shader in texture coordinates, the rows of the texture are in the image's order
+void BackgroundLayer::draw(Renderer& renderer, const QMatrix4x4& matrix)
+{
+    if (virtualTexture)
+    {
+        drawTiles(renderer, matrix);
+        return;
+    }
+
+    bindVbo();
+    bindTexture();
+
+    const auto erased = QRectF{ toFloat(erasedArea.left()) / getWidthF(), toFloat(erasedArea.top()) / getHeightF(),
+                                toFloat(erasedArea.width()) / getWidthF(), toFloat(erasedArea.height()) / getHeightF() };
+    renderer.draw(matrix, erased);
 }
 
-void BackgroundLayer::fillArea(const CopyData& data)
+// the viewport is mapped back into the layer, whose quad covers [-1, 1] in both directions, to find the part of
+// the image that is visible; the matrix is affine in x and y, so its 2D part is enough for that
+// every tile is drawn as a quad of its own, the default one scaled onto the tile's part of the layer
+void BackgroundLayer::drawTiles(Renderer& renderer, const QMatrix4x4& matrix)
 {
-    auto painter = QPainter{ &image };
-    painter.setBackground(QBrush{ Qt::gray });
+    const auto viewport = matrix.toTransform().inverted().mapRect(QRectF{ -1.0, -1.0, 2.0, 2.0 });
+    const auto width  = toDouble(getWidth());
+    const auto height = toDouble(getHeight());
+
+    const auto visible = QRectF{ (viewport.left() + 1.0) / 2.0 * width, (viewport.top() + 1.0) / 2.0 * height,
+                                 viewport.width() / 2.0 * width, viewport.height() / 2.0 * height };
+
+    const auto tiles = virtualTexture->prepare(visible, display.getZoom());
+
+    bindVbo();
+    bindTexture();
+
+    for (const auto& tile : tiles)
+    {
+        const auto& rect = tile.imageRect;
+
+        auto model = QMatrix4x4{};
+        model.translate(toFloat(2.0 * rect.center().x() / width - 1.0), toFloat(2.0 * rect.center().y() / height - 1.0));
+        model.scale(toFloat(rect.width() / width), toFloat(rect.height() / height));
+
+        renderer.draw(matrix * model, {}, tile.atlasRect);
+    }
+}
+
+// only copied when there is an erased area, which is painted in the color the shader draws it with
+auto BackgroundLayer::getImage() const -> QImage
+{
+    if (erasedArea.isEmpty())
+        return image;
+
+    auto img = image;
+    auto painter = QPainter{ &img };
+    painter.setBackground(QBrush{ qRgba(0x00, 0x00, 0x00, 0xff) });
     painter.setBackgroundMode(Qt::OpaqueMode);
-    painter.drawImage(data.sourcePosition, data.image);
-    
-    texture->setData(data.sourcePosition.left(), data.sourcePosition.topLeft().y(), 0,
-                     data.image.width(), data.image.height(), 0,
-                     QOpenGLTexture::PixelFormat::BGRA, QOpenGLTexture::UInt32_RGBA8_Rev, data.image.constBits());
+    painter.eraseRect(erasedArea);
+
+    return img;
 }
 
-FrameLayer::FrameLayer(IDisplay& display, int width, int height)
-    : LayerBase{ display, LayerBase::defaultVbo }
-    , texture{ [&]{
-        auto img = QImage{ width, height, QImage::Format_ARGB32 };
-        img.fill(qRgba(0x00, 0x00, 0x00, 0x00));
-        
-        auto painter = QPainter{ &img };
-        painter.setPen(QPen{ QBrush{ borderColor }, 4 });
-        painter.drawRect(QRect{ QPoint{ 1, 1 }, QPoint{ width - 2, height - 2 }});
+// Format_ARGB32 holds native 0xAARRGGBB words, which BGRA with UInt32_RGBA8_Rev reads on either byte order;
+// expects the GL context to be current, which is the case whenever the texture is bound for drawing
+void BackgroundLayer::uploadDirtyRegion()
+{
+    if (!texture || dirtyRegion.isEmpty())
+        return;
+
+    const auto regionBytes = dirtyRegion.getArea() * 4;
+
+    // the rows of a sub-rectangle are read straight out of the image, which is wider than the rectangle
+    auto options = QOpenGLPixelTransferOptions{};
+    options.setRowLength(image.bytesPerLine() / 4);
+    options.setAlignment(4);
+
+    for (const auto& rect : dirtyRegion.take())
+    {
+        const auto data = image.constScanLine(rect.top()) + rect.left() * 4;
+        texture->setData(rect.left(), rect.top(), 0, rect.width(), rect.height(), 0,
+                         QOpenGLTexture::PixelFormat::BGRA, QOpenGLTexture::UInt32_RGBA8_Rev, data, &options);
+    }
+
+    // the levels above the first one are generated again from the edited one
+    mipLevelsReady = 0;
+    texture->setMipMaxLevel(0);
+
+    uploadedBytes += regionBytes;
+    Logger::debug("Uploaded " + QString::number(regionBytes / 1024) + " KiB of the background texture");
+}
 
-        return util::make_owner<QOpenGLTexture>(img);
-    }() }
+void FrameLayer::draw(Renderer& renderer, const QMatrix4x4& matrix)
 {
+    bindVbo();
+    renderer.drawFrame(matrix, size, Renderer::frameColor, Renderer::frameWidth);
 }
 
 auto FrameLayer::getScale() const -> QVector3D
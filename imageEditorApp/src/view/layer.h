@@ -1,9 +1,14 @@
 #pragma once
 
+#include <dirtyregion.h>
 #include "idisplay.h"
+#include <renderer.h>
 #include <util.h>
-#include "vertexbuffer.h"
+#include <vertexbuffer.h>
+#include <virtualtexture.h>
 
+#include <memory>
+#include <optional>
 #include <QImage>
 #include <QMatrix4x4>
 #include <QOpenGLTexture>
@@ -24,25 +29,30 @@ public:
     LayerBase(LayerBase&&) = delete;
     LayerBase& operator=(LayerBase&&) = delete;
 
-    virtual auto getWidth() const -> int            { return getTexture().width(); }
-    virtual auto getHeight() const -> int           { return getTexture().height(); }
+    virtual auto getWidth() const -> int = 0;
+    virtual auto getHeight() const -> int = 0;
     virtual auto getWidthF() const -> float         { return toFloat(getWidth()); }
     virtual auto getHeightF() const -> float        { return toFloat(getHeight()); }
     virtual auto getAspect() const -> float         { return getWidthF() / getHeightF(); }
     
-    virtual auto getTextureId() const -> uint       { return getTexture().textureId(); }
-    virtual void bindTexture()                      { getTexture().bind(); }
-    
     virtual auto getTranslate() const -> QVector3D  { return translateDelta * display.getZoom(); }
-    virtual void translate(const QVector3D& amount) { translateDelta += amount; }
-    virtual void translateTo(const QVector3D& dest) { translateDelta = dest / display.getZoom(); }
+    virtual void translate(const QVector3D& amount) { translateDelta += amount; invalidateTransforms(); }
+    virtual void translateTo(const QVector3D& dest) { translateDelta = dest / display.getZoom(); invalidateTransforms(); }
     
     virtual auto getRotate() const -> float         { return -rotateDelta; }
-    virtual void rotateTo(float angle)              { this->rotateDelta = -angle; }
+    virtual void rotateTo(float angle)              { this->rotateDelta = -angle; invalidateTransforms(); }
     virtual void bindVbo()                          { vbo->bindVbo(); }
     
     virtual auto getScale() const -> QVector3D = 0;
 
+    // draws the layer with its vertex buffer, the matrix maps it to the viewport
+    virtual void draw(Renderer& renderer, const QMatrix4x4& matrix) = 0;
+
+    // the layer's place in the display's normalized coordinates, without the camera and the projection
+    auto getModelMatrix() const -> const QMatrix4x4&    { return getTransforms().model; }
+    auto getInverseMatrix() const -> const QMatrix4x4&  { return getTransforms().inverse; }
+    auto containsWinCoord(const QPoint& wincoord) const -> bool;
+
     virtual auto layerRectFromWinRect(const QRect& winrect) const -> QRect;
     virtual auto layerCoordFromWinCoord(const QPoint& wincoord) const -> QPoint;
     virtual auto texCoordFromWinCoord(const QPoint& wincoord) const -> QPointF;
@@ -55,10 +65,22 @@ public:
 
 
 protected:
+    // Transforms: The model matrix and the one that maps the window back into the layer, they are rebuilt
+    //             when the layer is moved, rotated or resized, or when the zoom or the display size changed
+    struct Transforms
+    {
+        QMatrix4x4 model;
+        QMatrix4x4 inverse;
+        float      zoom{ 0.0f };
+        QSize      displaySize;
+        bool       valid{ false };
+    };
+
     IDisplay&                     display;
     std::shared_ptr<VertexBuffer> vbo;
     QVector3D                     translateDelta;
     float                         rotateDelta;
+    mutable Transforms            transforms;
 
     explicit LayerBase(IDisplay& display, std::shared_ptr<VertexBuffer> vbo)
         : display{ display }
@@ -68,6 +90,25 @@ protected:
     {
     }
 
+    // to be called by everything that changes the scale, apart from the zoom and the display size
+    void invalidateTransforms()                     { transforms.valid = false; }
+    auto getTransforms() const -> const Transforms&;
+};
+
+// TexturedLayer: A layer that shows a texture, which is drawn through the color or grayscale shaders
+class TexturedLayer : public LayerBase
+{
+public:
+    virtual auto getTextureId() const -> uint       { return getTexture().textureId(); }
+    virtual void bindTexture()                      { getTexture().bind(); }
+
+    // inherited via LayerBase
+    virtual void draw(Renderer& renderer, const QMatrix4x4& matrix) override;
+
+protected:
+    explicit TexturedLayer(IDisplay& display, std::shared_ptr<VertexBuffer> vbo)
+        : LayerBase{ display, std::move(vbo) } { }
+
     virtual auto getTexture() -> QOpenGLTexture& = 0;
     virtual auto getTexture() const -> const QOpenGLTexture& = 0;
 };
@@ -82,29 +123,22 @@ struct CopyData
     , sourcePosition{ sourcePosition } { }
 };
 
+// the cut area is sampled from the background texture, like a copy, while the background shows it as erased
 struct CutData : public CopyData
 {
-    IDisplay&                 display;
-    util::owner_ptr<QOpenGLTexture> texture;
-
-    explicit CutData(IDisplay& display, const QImage& image, const QRect& sourcePosition, util::owner_ptr<QOpenGLTexture> texture)
-        : CopyData{ image, sourcePosition }
-        , display{ display }
-        , texture{ std::move(texture) } { }
-    
-    ~CutData() { display.deleteTexture(std::move(texture)); }
+    using CopyData::CopyData;
 };
 
-class UpperLayer : public LayerBase
+class UpperLayer : public TexturedLayer
 {
 public:
     static util::owner_ptr<QOpenGLTexture> overlayTexture;
     
     explicit UpperLayer(IDisplay& display, std::shared_ptr<VertexBuffer> vbo = LayerBase::defaultVbo)
-        : LayerBase{ display, std::move(vbo) }
+        : TexturedLayer{ display, std::move(vbo) }
         , texture{ overlayTexture.get() } { }
 
-    // inherited via LayerBase
+    // inherited via TexturedLayer
     virtual auto getTexture() -> QOpenGLTexture& override             { return *texture; }
     virtual auto getTexture() const -> const QOpenGLTexture& override { return *texture; };
     virtual auto getWidth() const -> int override                     { return selectSize.width(); }
@@ -117,12 +151,12 @@ public:
     auto getCutData() const -> const CutData*                         { return cutData.get(); }
 
     void setCopyData(const QRect& sourcePosition, QImage image, std::shared_ptr<VertexBuffer> vbo, QOpenGLTexture* texture);
-    void setCutData(IDisplay&, const QImage& image, const QRect& sourcePosition, util::owner_ptr<QOpenGLTexture> texture);
+    void setCutData(const QRect& sourcePosition, QImage image, std::shared_ptr<VertexBuffer> vbo, QOpenGLTexture* texture);
 
     auto inSelectMode() const -> bool                                 { return !copyData && !cutData; }
     void setSelectLeftTop(const QPoint& pixel)                        { selectLeftTop = pixel; }
     void setSelectRightBottom(const QPoint& pixel)                    { selectRightBottom = pixel; }
-    void setSelectSize(const QSize& size)                             { selectSize = size; }
+    void setSelectSize(const QSize& size)                             { selectSize = size; invalidateTransforms(); }
 
 private:
     QOpenGLTexture*                 texture;
@@ -133,44 +167,120 @@ private:
     QSize                           selectSize;
 };
 
-class BackgroundLayer : public LayerBase
+class BackgroundLayer : public TexturedLayer
 {
 public:
-    explicit BackgroundLayer(IDisplay& display, const QImage& image)
-        : LayerBase{ display, LayerBase::defaultVbo }
+    static const qsizetype incrementalMipBytes;
+
+    // the texture is filled asynchronously, meanwhile the placeholder is shown if there is one, at the size
+    // of the image it holds, which is the new one's if none is given
+    explicit BackgroundLayer(IDisplay& display, const QImage& image, util::owner_ptr<QOpenGLTexture> placeholder = nullptr,
+                             const QSize& placeholderSize = {})
+        : TexturedLayer{ display, LayerBase::defaultVbo }
         , image{ image }
-        , texture{ display.makeTexture(image) } { }
+        , texture{ display.allocateTexture(image.size()) }
+        , placeholder{ std::move(placeholder) }
+        , placeholderSize{ placeholderSize.isEmpty() ? image.size() : placeholderSize }
+        , dirtyRegion{ image.rect() } { }
 
-    virtual ~BackgroundLayer() override                               { display.deleteTexture(std::move(texture)); }
+    // with a texture that holds the image already, e.g. one from the display's texture cache,
+    // whose levels up to mipLevelsReady are complete
+    explicit BackgroundLayer(IDisplay& display, const QImage& image, util::owner_ptr<QOpenGLTexture> texture, int mipLevelsReady)
+        : TexturedLayer{ display, LayerBase::defaultVbo }
+        , image{ image }
+        , texture{ std::move(texture) }
+        , placeholder{ nullptr }
+        , dirtyRegion{ image.rect() }
+        , uploaded{ true }
+        , mipLevelsReady{ mipLevelsReady } { }
 
-    // inherited via LayerBase
-    virtual auto getTexture() -> QOpenGLTexture& override             { return *texture; }
-    virtual auto getTexture() const -> const QOpenGLTexture& override { return *texture; };
+    // for an image that is too large for a texture of its own, it is shown tile by tile through the virtual
+    // texture instead, which needs nothing to be uploaded up front
+    explicit BackgroundLayer(IDisplay& display, const QImage& image, std::unique_ptr<VirtualTexture> virtualTexture)
+        : TexturedLayer{ display, LayerBase::defaultVbo }
+        , image{ image }
+        , texture{ nullptr }
+        , placeholder{ nullptr }
+        , virtualTexture{ std::move(virtualTexture) }
+        , uploaded{ true } { }
+
+    virtual ~BackgroundLayer() override;
+
+    // inherited via TexturedLayer
+    virtual auto getTexture() -> QOpenGLTexture& override;
+    virtual auto getTexture() const -> const QOpenGLTexture& override;
+    virtual auto getWidth() const -> int override                     { return image.width(); }
+    virtual auto getHeight() const -> int override                    { return image.height(); }
     virtual auto getScale() const -> QVector3D override;
+    virtual void bindTexture() override;
+    virtual void draw(Renderer& renderer, const QMatrix4x4& matrix) override;
     
-    auto getImage() const -> QImage                                   { return image; }
-    void eraseArea(const QRect& rect);
-    void fillArea(const CopyData& data);
+    // with the erased area painted over, as the display shows it
+    auto getImage() const -> QImage;
+    auto getImageKey() const -> qint64                                { return image.cacheKey(); }
+
+    // in virtual mode the texture is the atlas of the tiles, which does not hold the image as a whole
+    auto isVirtual() const -> bool                                    { return !!virtualTexture; }
+    auto hasPendingTiles() const -> bool;
+    auto getTileStats() const -> std::optional<CacheStats>;
+
+    // the area is drawn as erased, while the image and the texture keep its pixels, so that neither a cut
+    // nor undoing it uploads anything; one area is erased at a time
+    void eraseArea(const QRect& rect)                                 { erasedArea = rect; }
+    void restoreErasedArea()                                          { erasedArea = QRect{}; }
+    auto getErasedArea() const -> const QRect&                        { return erasedArea; }
+
+    // the pixels of the image that differ from the texture, e.g. where a paste changed the previous
+    // background, whose texture is reused; they are uploaded the next time the texture is bound
+    void markDirty(const QRect& rect)                                 { dirtyRegion.add(rect); }
+
+    auto getUploadTarget() -> QOpenGLTexture&                         { return *texture; }
+    auto isUploaded() const -> bool                                   { return uploaded; }
+    auto isDisplayable() const -> bool                                { return uploaded || placeholder; }
+    auto hasPlaceholder() const -> bool                               { return !!placeholder; }
+    auto getShownSize() const -> QSize                                { return placeholder ? placeholderSize : image.size(); }
+    auto isComplete() const -> bool;
+    void setUploaded();
+    auto takePlaceholder() -> util::owner_ptr<QOpenGLTexture>         { return std::move(placeholder); }
+    void uploadOnBind();
+    auto releaseShownTexture() -> util::owner_ptr<QOpenGLTexture>;
+    auto takeUploadedBytes() -> qint64;
+
+    // the mip levels are generated once the texture is complete, and again after every edit
+    auto hasPendingMipLevels() const -> bool;
+    void generateMipLevels();
     
 private:
     QImage                          image;
     util::owner_ptr<QOpenGLTexture> texture;
+    util::owner_ptr<QOpenGLTexture> placeholder;    // the previous background, while the texture is incomplete
+    QSize                           placeholderSize;
+    std::unique_ptr<VirtualTexture> virtualTexture{ nullptr };
+    DirtyRegion                     dirtyRegion;    // changed since the last upload
+    bool                            uploaded{ false };
+    qint64                          uploadedBytes{ 0 };     // since the last call to takeUploadedBytes
+    int                             mipLevelsReady{ 0 };    // the texture's max level, the ones above are stale
+    QRect                           erasedArea;
+
+    void uploadDirtyRegion();
+    void drawTiles(Renderer& renderer, const QMatrix4x4& matrix);
 };
 
+// FrameLayer: The border around the image, and the coordinate system of the image for the other layers,
+//             it is drawn procedurally by the renderer, so it has no texture
 class FrameLayer : public LayerBase
 {
 public:
-    static const QRgb borderColor;
-
-    explicit FrameLayer(IDisplay& display, int width, int height);
-    
-    virtual ~FrameLayer() override                                    { display.deleteTexture(std::move(texture)); }
+    explicit FrameLayer(IDisplay& display, int width, int height)
+        : LayerBase{ display, LayerBase::defaultVbo }
+        , size{ width, height } { }
 
     // inherited via LayerBase
-    virtual auto getTexture() -> QOpenGLTexture& override             { return *texture; }
-    virtual auto getTexture() const -> const QOpenGLTexture& override { return *texture; }
+    virtual auto getWidth() const -> int override                     { return size.width(); }
+    virtual auto getHeight() const -> int override                    { return size.height(); }
     virtual auto getScale() const -> QVector3D override;
+    virtual void draw(Renderer& renderer, const QMatrix4x4& matrix) override;
 
 private:
-    util::owner_ptr<QOpenGLTexture> texture;
+    QSize size;
 };
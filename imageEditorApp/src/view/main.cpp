@@ -1,9 +1,32 @@
+#include "batchprocessor.h"
 #include <mainwindow.h>
 #include <QApplication>
+#include <QCoreApplication>
 #include <cstring>
 
 int main(int argc, char *argv[])
 {
+    // used by the settings and cache locations
+    QCoreApplication::setOrganizationName("imageEditor");
+    QCoreApplication::setApplicationName("imageEditor");
+
+    // the batch mode does not open a window, so it does not need a QApplication
+    if (BatchProcessor::isRequested(argc, argv))
+    {
+        QCoreApplication a(argc, argv);
+
+        const auto options = BatchProcessor::parseArguments(a.arguments());
+        if (!options)
+            return 1;
+
+        return BatchProcessor{ *options }.run();
+    }
+
+    // for comparing the startup time, the shader programs are compiled from source every time
+    for (int i = 1; i < argc; ++i)
+        if (strcmp(argv[i], "--no-shader-cache") == 0)
+            QCoreApplication::setAttribute(Qt::AA_DisableShaderDiskCache);
+
     QApplication a(argc, argv);
 
     bool debug = argc > 1 && strcmp(argv[1], "-d") == 0;
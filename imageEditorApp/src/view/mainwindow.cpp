@@ -1,14 +1,16 @@
 #include "mainwindow.h"
 #include "settingswidget.h"
 #include "ui_mainwindow.h"
+#include <idataaccess.h>
 #include <logger.h>
-#include "openglexception.h"
+#include <openglexception.h>
 #include <util.h>
 
-#include <chrono>
 #include <memory>
 #include <QDebug>
 #include <QDesktopWidget>
+#include <QDir>
+#include <QElapsedTimer>
 #include <QFileDialog>
 #include <QFormLayout>
 #include <QHBoxLayout>
@@ -27,12 +29,14 @@ const int                   MainWindow::defaultWindowWidth{ 1366 };
 const int                   MainWindow::defaultWindowHeight{ 768 };
 const int                   MainWindow::messageTimeout{ 5000 };
 const IEditor::InterpMethod MainWindow::defaultInterpMethod{ IEditor::InterpMethod::BILINEAR };
+const QString               MainWindow::projectSuffix{ "iep" };
+const QStringList           MainWindow::imageFilters{ "*.png", "*.bmp", "*.ppm", "*.xpm", "*.jpg", "*.jpeg" };
+const int                   MainWindow::prefetchRadius{ 2 };
 
 MainWindow::MainWindow(bool debug, QWidget *parent)
     : QMainWindow{ parent }
     , editor{ fact::makeEditor(defaultInterpMethod, debug) }
     , ui{ util::make_owner<Ui::MainWindow>() }
-    , resizeTimer{ new QTimer{ this }}
     , aboutDialog{ new AboutDialog{ this }}
     , keybindingsDialog{ new KeybindingsDialog{ this }}
     , affineDockWidget{ new QDockWidget{ this }}
@@ -43,6 +47,8 @@ MainWindow::MainWindow(bool debug, QWidget *parent)
     , settingsWidget{ new SettingsWidget{ defaultInterpMethod, this }}
     , confirmDockWidget{ new QDockWidget{ this }}
     , confirmWidget{ new ConfirmWidget{ this }}
+    , recentDockWidget{ new QDockWidget{ this }}
+    , recentFilesWidget{ new RecentFilesWidget{ [this](const QString& filePath) { return editor->loadThumbnail(filePath); }, this }}
     , statusBar{ new StatusBar{ this }}
 {
     try
@@ -63,20 +69,18 @@ MainWindow::MainWindow(bool debug, QWidget *parent)
     setupColorWidget();
     setupSettingsWidget();
     setupConfirmWidget();
+    setupRecentFilesWidget();
     setupStatusBar();
 
     Logger::setDebug(debug);
 
     connect(&Logger::getInstance(), &Logger::logToView, this, &MainWindow::status);
-    connect(resizeTimer, &QTimer::timeout, this, [this] {
-        enableWidgetUpdates(true);
-        update();
-        resizeTimer->stop();
-    });
 }
 
 MainWindow::~MainWindow()
 {
+    // its worker loads thumbnails through the editor, so it is joined before the editor is destroyed
+    delete recentFilesWidget;
     ui.reset();
 }
 
@@ -99,6 +103,15 @@ auto MainWindow::mergeImages(QImage lower, QImage upper, QRect upperRect, float
     return editor->mergeImages(lower, upper, upperRect, upperAngle);
 }
 
+// the GPU backend bakes the colors by reading back the display, which is limited to what it can render
+auto MainWindow::adjustColors(const QImage& image, bool grayscale, bool renderable) -> std::optional<QImage>
+{
+    if (renderable && editor->getMergeBackend() == IEditor::MergeBackend::GPU)
+        return std::nullopt;
+
+    return grayscale ? editor->toGrayscale(image) : editor->adjustColors(image, getColorData());
+}
+
 void MainWindow::setupDockWidget(QDockWidget* const dockWidget, QWidget* const widget, const QString& title, Qt::DockWidgetArea area)
 {
     dockWidget->setMinimumSize({ 250, 0 });
@@ -114,6 +127,14 @@ void MainWindow::setupActions()
     connect(ui->actionOpen, &QAction::triggered, this, &MainWindow::open);
     connect(openShortcut, &QShortcut::activated, this, &MainWindow::open);
 
+    auto nextImageShortcut = new QShortcut{ QKeySequence{ tr("PgDown") }, this };
+    connect(ui->actionNextImage, &QAction::triggered, [this]{ openNeighbour(1); });
+    connect(nextImageShortcut, &QShortcut::activated, [this]{ openNeighbour(1); });
+
+    auto previousImageShortcut = new QShortcut{ QKeySequence{ tr("PgUp") }, this };
+    connect(ui->actionPreviousImage, &QAction::triggered, [this]{ openNeighbour(-1); });
+    connect(previousImageShortcut, &QShortcut::activated, [this]{ openNeighbour(-1); });
+
     auto saveShortcut = new QShortcut{ QKeySequence{ tr("Ctrl+S", "File|Save") }, this };
     connect(ui->actionSave, &QAction::triggered, this, &MainWindow::save);
     connect(saveShortcut, &QShortcut::activated, this, &MainWindow::save);
@@ -170,6 +191,9 @@ void MainWindow::setupActions()
     auto resetRotationShortcut = new QShortcut{ QKeySequence{ tr("Ctrl+Up") }, this };
     connect(resetRotationShortcut, &QShortcut::activated, [this]{  resetRotation(); });
 
+    auto hudShortcut = new QShortcut{ QKeySequence{ tr("F12") }, this };
+    connect(hudShortcut, &QShortcut::activated, [this]{ displayWidget->setHudEnabled(!displayWidget->isHudEnabled()); });
+
     connect(ui->actionMirrorHorizontally, &QAction::triggered, this, &MainWindow::mirrorHorizontally);
     connect(ui->actionMirrorVertically, &QAction::triggered, this, &MainWindow::mirrorVertically);
     connect(ui->actionAbout, &QAction::triggered, [this]{ aboutDialog->show(); });
@@ -274,6 +298,22 @@ void MainWindow::setupSettingsWidget()
 
         status("Switched to " + msg + " overlay color");
     });
+
+    connect(settingsWidget, &SettingsWidget::compressionChanged, this, [this](SettingsWidget::CompressionIndex index) {
+        const auto level = toCompressionLevel(index);
+        if (!level)
+            return;
+
+        editor->setCompressionLevel(*level);
+    });
+
+    connect(settingsWidget, &SettingsWidget::mergeChanged, this, [this](SettingsWidget::MergeIndex index) {
+        const auto backend = toMergeBackend(index);
+        if (!backend)
+            return;
+
+        editor->setMergeBackend(*backend);
+    });
 }
 
 void MainWindow::setupConfirmWidget()
@@ -286,6 +326,14 @@ void MainWindow::setupConfirmWidget()
     connect(confirmWidget, &ConfirmWidget::actionCancelled, this, &MainWindow::cancelAction);
 }
 
+void MainWindow::setupRecentFilesWidget()
+{
+    setupDockWidget(recentDockWidget, recentFilesWidget, "Recent");
+    recentFilesWidget->setFiles(editor->getRecentFiles());
+
+    connect(recentFilesWidget, &RecentFilesWidget::fileSelected, this, &MainWindow::openFile);
+}
+
 void MainWindow::setupStatusBar()
 {
     ui->statusbar->addWidget(statusBar);
@@ -297,34 +345,169 @@ void MainWindow::setupStatusBar()
     });
 }
 
-void MainWindow::resizeEvent(QResizeEvent* event)
+void MainWindow::open()
 {
-    using namespace std::chrono_literals;
-    
-    resizeTimer->start(150ms);
-    enableWidgetUpdates(false);
-    QMainWindow::resizeEvent(event);
+    const auto filePath = QFileDialog::getOpenFileName(this, "Open Image", "./",
+                                                       "Images (*.png *.bmp *.ppm *.xpm *.jpg);;"
+                                                       "Projects (*." + projectSuffix + ")");
+    openFile(filePath);
 }
 
-void MainWindow::open()
+void MainWindow::openFile(const QString& filePath)
+{
+    if (QFileInfo{ filePath }.suffix() == projectSuffix)
+    {
+        if (openProject(filePath))
+            addRecentFile(filePath);
+
+        return;
+    }
+
+    if (!openImage(filePath))
+        return;
+
+    browseDirectory(filePath);
+    addRecentFile(filePath);
+}
+
+auto MainWindow::openImage(const QString& filePath) -> bool
 {
-    const auto filePath = QFileDialog::getOpenFileName(this, "Open Image", "./",
-                                                       "Images (*.png *.bmp *.ppm *.xpm *.jpg)");
     if (!editor->loadImage(filePath))
     {
         status("Image not opened");
-        return;
+        return false;
     }
 
     const auto img = editor->getImage();
     if (!img)
     {
         status("Invalid image!");
-        return;
+        return false;
     }
             
     loadImage(*img);
-                
+    fileOpened(filePath, *img);
+    return true;
+}
+
+void MainWindow::openNeighbour(int step)
+{
+    const auto index = directoryIndex + step;
+    if (directoryIndex < 0 || index < 0 || index >= directoryFiles.size())
+    {
+        status(step > 0 ? "No next image" : "No previous image");
+        return;
+    }
+
+    auto timer = QElapsedTimer{};
+    timer.start();
+
+    const auto hitsBefore = editor->getCacheStats().hits;
+
+    // an image that can not be opened is stepped over, so that browsing does not get stuck on it
+    directoryIndex = index;
+    const auto opened = openImage(directoryFiles[index]);
+    prefetchNeighbours(step);
+
+    if (!opened)
+        return;
+
+    const auto elapsed = toDouble(timer.nsecsElapsed()) / 1e6;
+    const auto stats   = editor->getCacheStats();
+    const auto hit     = stats.hits > hitsBefore;
+
+    status(QString{ "Image %1/%2 opened in %3 ms (%4), cache hit rate %5 %" }
+           .arg(index + 1).arg(directoryFiles.size()).arg(elapsed, 0, 'f', 1)
+           .arg(hit ? "cached" : "decoded").arg(100.0 * stats.hitRate(), 0, 'f', 0));
+
+    Logger::debug(QString{ "Image cache: %1 hits, %2 misses, %3 prefetched, %4 images, %5 of %6 MiB" }
+                  .arg(stats.hits).arg(stats.misses).arg(stats.prefetched).arg(stats.images)
+                  .arg(stats.bytes / (1024u * 1024u)).arg(stats.budget / (1024u * 1024u)));
+}
+
+void MainWindow::browseDirectory(const QString& filePath)
+{
+    const auto fileInfo = QFileInfo{ filePath };
+    const auto dir      = fileInfo.absoluteDir();
+
+    directoryFiles.clear();
+    for (const auto& name : dir.entryList(imageFilters, QDir::Files, QDir::Name | QDir::IgnoreCase))
+        directoryFiles.append(dir.absoluteFilePath(name));
+
+    directoryIndex = directoryFiles.indexOf(fileInfo.absoluteFilePath());
+
+    ui->actionNextImage->setEnabled(directoryIndex >= 0);
+    ui->actionPreviousImage->setEnabled(directoryIndex >= 0);
+
+    prefetchNeighbours(1);
+}
+
+// decodes the images around the current one in the background, the ones in the browsing direction first
+void MainWindow::prefetchNeighbours(int step)
+{
+    if (directoryIndex < 0)
+        return;
+
+    const auto direction = step < 0 ? -1 : 1;
+    auto neighbours = QStringList{};
+
+    for (const auto sign : { direction, -direction })
+    {
+        for (int i = 1; i <= prefetchRadius; ++i)
+        {
+            const auto index = directoryIndex + sign * i;
+            if (index >= 0 && index < directoryFiles.size())
+                neighbours.append(directoryFiles[index]);
+        }
+    }
+
+    editor->prefetchImages(neighbours);
+}
+
+auto MainWindow::openProject(const QString& filePath) -> bool
+{
+    const auto project = editor->loadProject(filePath);
+    if (!project)
+    {
+        status("Project not opened");
+        return false;
+    }
+
+    // projects are not browsed, stepping to an image would drop the history
+    directoryFiles.clear();
+    directoryIndex = -1;
+    ui->actionNextImage->setEnabled(false);
+    ui->actionPreviousImage->setEnabled(false);
+
+    loadImage(project->image);
+    resetSettings();
+
+    if (project->layer)
+    {
+        if (displayWidget->restoreLayerState(*project->layer))
+        {
+            colorDockWidget->setEnabled(false);
+            confirmDockWidget->setEnabled(true);
+        }
+        else
+        {
+            status("Failed to restore the pending layer!");
+        }
+    }
+
+    fileOpened(filePath, project->image);
+    return true;
+}
+
+// only files opened or saved by the user are remembered, not the ones stepped through while browsing
+void MainWindow::addRecentFile(const QString& filePath)
+{
+    editor->addRecentFile(filePath);
+    recentFilesWidget->setFiles(editor->getRecentFiles());
+}
+
+void MainWindow::fileOpened(const QString& filePath, const QImage& img)
+{
     // enable UI
     ui->actionSave->setEnabled(true);
     ui->menuEdit->setEnabled(true);
@@ -333,7 +516,7 @@ void MainWindow::open()
 
     const auto fileInfo = QFileInfo{ filePath };
     const auto fileName = fileInfo.completeBaseName() + "." + fileInfo.suffix();
-    const auto fileResolution = QString::number(img->width()) + "x" + QString::number(img->height());
+    const auto fileResolution = QString::number(img.width()) + "x" + QString::number(img.height());
     const auto fileSize = this->locale().formattedDataSize(fileInfo.size());
     statusBar->setDetails(fileName, fileResolution, fileSize);
     
@@ -342,8 +525,28 @@ void MainWindow::open()
 
 void MainWindow::save()
 {
-    const auto fileName = QFileDialog::getSaveFileName(this);
-    editor->saveImage(fileName);
+    const auto fileName = QFileDialog::getSaveFileName(this, "Save Image", "./",
+                                                       "Images (*.png *.bmp *.ppm *.xpm *.jpg);;"
+                                                       "Projects (*." + projectSuffix + ")");
+    if (fileName.isEmpty())
+        return;
+
+    // projects keep the history and the pending layer, while images are flattened
+    if (QFileInfo{ fileName }.suffix() == projectSuffix)
+    {
+        if (!editor->saveProject(fileName, displayWidget->getLayerState()))
+        {
+            popupError("Failed to save project " + fileName);
+            return;
+        }
+    }
+    else if (!editor->saveImage(fileName))
+    {
+        popupError("Failed to save image " + fileName);
+        return;
+    }
+
+    addRecentFile(fileName);
     setWindowTitle("Image Editor - " + fileName);
 }
 
@@ -526,20 +729,6 @@ void MainWindow::setEditingDocksEnabled(bool enable)
         dockWidget->setEnabled(enable);
 }
 
-void MainWindow::enableWidgetUpdates(bool enable)
-{
-    for (auto dockWidget : getDockWidgets())
-    {
-        if (enable)
-            dockWidget->show();
-        else
-            dockWidget->hide();
-    }
-
-    setUpdatesEnabled(enable);
-    displayWidget->setUpdatesEnabled(enable);
-}
-
 void MainWindow::rotate(float angle)
 {
     const auto rotate = displayWidget->getRotate();
@@ -566,6 +755,7 @@ auto MainWindow::getDockWidgets() const -> std::vector<QDockWidget*>
 {
     auto docks = std::vector<QDockWidget*>{ getEditingDockWidgets() };
     docks.push_back(confirmDockWidget);
+    docks.push_back(recentDockWidget);
     return docks;
 }
 
@@ -584,6 +774,28 @@ auto MainWindow::toInterpMethod(SettingsWidget::InterpIndex index) const -> std:
     }
 }
 
+// zlib levels, the default one is the balanced choice
+auto MainWindow::toCompressionLevel(SettingsWidget::CompressionIndex index) const -> std::optional<int>
+{
+    switch (index)
+    {
+        case SettingsWidget::CompressionIndex::FAST:     return 1;
+        case SettingsWidget::CompressionIndex::BALANCED: return IDataAccess::defaultCompressionLevel;
+        case SettingsWidget::CompressionIndex::SMALL:    return 9;
+        default:                                         return {};
+    }
+}
+
+auto MainWindow::toMergeBackend(SettingsWidget::MergeIndex index) const -> std::optional<IEditor::MergeBackend>
+{
+    switch (index)
+    {
+        case SettingsWidget::MergeIndex::CPU: return IEditor::MergeBackend::CPU;
+        case SettingsWidget::MergeIndex::GPU: return IEditor::MergeBackend::GPU;
+        default:                              return {};
+    }
+}
+
 auto MainWindow::zoomToString(float zoom) const -> QString
 {
     return QString::number(100 * zoom) + " %";
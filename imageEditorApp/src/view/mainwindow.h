@@ -8,6 +8,7 @@
 #include <ieditor.h>
 #include "imainwindow.h"
 #include "helpdialogs.h"
+#include "recentfileswidget.h"
 #include "settingswidget.h"
 #include "statusbar.h"
 #include <util.h>
@@ -17,7 +18,6 @@
 #include <QMessageBox>
 #include <QMainWindow>
 #include <QLabel>
-#include <QTimer>
 #include <qnamespace.h>
 #include <qwidget.h>
 
@@ -37,19 +37,19 @@ public:
     virtual auto getColorData() -> ColorData override;
     virtual auto mergeImages(QImage lower, QImage upper, QRect upperRect, float upperAngle)
         -> QImage override;
-
-protected:
-    virtual void resizeEvent(QResizeEvent* event) override;
+    virtual auto adjustColors(const QImage& image, bool grayscale, bool renderable) -> std::optional<QImage> override;
 
 private:
     static const int                   defaultWindowWidth;
     static const int                   defaultWindowHeight;
     static const int                   messageTimeout;
     static const IEditor::InterpMethod defaultInterpMethod;
+    static const QString               projectSuffix;
+    static const QStringList           imageFilters;
+    static const int                   prefetchRadius;
 
     const std::unique_ptr<IEditor>  editor;
     util::owner_ptr<Ui::MainWindow> ui;
-    QTimer* const                   resizeTimer;
     AboutDialog* const              aboutDialog;
     KeybindingsDialog* const        keybindingsDialog;
     DisplayWidget*                  displayWidget;
@@ -61,7 +61,11 @@ private:
     SettingsWidget* const           settingsWidget;
     QDockWidget* const              confirmDockWidget;
     ConfirmWidget* const            confirmWidget;
+    QDockWidget* const              recentDockWidget;
+    RecentFilesWidget* const        recentFilesWidget;
     StatusBar* const                statusBar;
+    QStringList                     directoryFiles;     // the images next to the opened one, for browsing
+    int                             directoryIndex{ -1 };
 
     void setupDockWidget(QDockWidget* const dockWidget, QWidget* const widget, const QString& title,
                          Qt::DockWidgetArea area = Qt::RightDockWidgetArea);
@@ -72,9 +76,18 @@ private:
     void setupColorWidget();
     void setupSettingsWidget();
     void setupConfirmWidget();
+    void setupRecentFilesWidget();
     void setupStatusBar();
 
     void open();
+    void openFile(const QString& filePath);
+    auto openImage(const QString& filePath) -> bool;
+    auto openProject(const QString& filePath) -> bool;
+    void addRecentFile(const QString& filePath);
+    void openNeighbour(int step);
+    void browseDirectory(const QString& filePath);
+    void prefetchNeighbours(int step);
+    void fileOpened(const QString& filePath, const QImage& img);
     void save();
     void quit();
     void zoomIn();
@@ -93,7 +106,6 @@ private:
     void resetSettings();
     void setZoom(int zoom);
     void setEditingDocksEnabled(bool enable);
-    void enableWidgetUpdates(bool enable);
     void rotate(float angle);
     void resetRotation();
 
@@ -102,6 +114,8 @@ private:
     auto getEditableWidgets() const -> std::vector<IEditableWidget*>;
     
     auto toInterpMethod(SettingsWidget::InterpIndex index) const -> std::optional<IEditor::InterpMethod>;
+    auto toCompressionLevel(SettingsWidget::CompressionIndex index) const -> std::optional<int>;
+    auto toMergeBackend(SettingsWidget::MergeIndex index) const -> std::optional<IEditor::MergeBackend>;
     auto zoomToString(float zoom) const -> QString;
 
     auto popupInformation(const QString& message, const QString& title = "Information") -> int;
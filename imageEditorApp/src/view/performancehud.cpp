@@ -0,0 +1,76 @@
+#include "performancehud.h"
+#include <util.h>
+
+#include <algorithm>
+#include <vector>
+#include <QFont>
+#include <QFontMetrics>
+#include <QRect>
+#include <QString>
+
+using namespace util::types;
+
+const QRgb PerformanceHud::backgroundColor{ qRgba(0x00, 0x00, 0x00, 0xb0) };
+const QRgb PerformanceHud::textColor{ qRgba(0xe0, 0xe0, 0xe0, 0xff) };
+const int  PerformanceHud::margin{ 8 };
+
+namespace
+{
+    auto format(double milliseconds) -> QString
+    {
+        return QString::number(milliseconds, 'f', 2) + " ms";
+    }
+
+    auto format(const std::optional<double>& milliseconds) -> QString
+    {
+        return milliseconds ? format(*milliseconds) : QString{ "-" };
+    }
+}
+
+void PerformanceHud::draw(QPainter& painter, const FrameStats& stats, qint64 textureMemory,
+                          const CacheStats& textureCache, const std::optional<CacheStats>& tiles) const
+{
+    if (!enabled)
+        return;
+
+    auto lines = std::vector<QString>{
+        "FPS        " + QString::number(stats.getFps()),
+        "CPU frame  p50 " + format(stats.getCpuPercentile(0.5)) + "  p95 " + format(stats.getCpuPercentile(0.95)) +
+                  "  p99 " + format(stats.getCpuPercentile(0.99)),
+        "GPU frame  " + (stats.getGpuTime() ? format(*stats.getGpuTime()) : QString{ "no timer queries" }),
+        "Uploaded   " + QString::number(stats.getUploadedBytes() / 1024) + " KiB this frame",
+        "Textures   " + QString::number(textureMemory / (1024 * 1024)) + " MiB",
+        "Tex cache  " + QString::number(textureCache.hitRate() * 100.0, 'f', 0) + " % hits  " +
+                  QString::number(textureCache.images) + " textures  " +
+                  QString::number(textureCache.bytes / (1024u * 1024u)) + " MiB",
+        "Merge      " + format(mergeTime),
+        "Readback   " + format(readbackTime)
+    };
+
+    // after the texture cache
+    if (tiles)
+        lines.insert(lines.begin() + 6, "Tiles      " + QString::number(tiles->hitRate() * 100.0, 'f', 0) + " % hits  " +
+                                        QString::number(tiles->images) + " resident  " +
+                                        QString::number(tiles->bytes / (1024u * 1024u)) + " of " +
+                                        QString::number(tiles->budget / (1024u * 1024u)) + " MiB");
+
+    auto font = QFont{ "Monospace" };
+    font.setStyleHint(QFont::TypeWriter);
+    painter.setFont(font);
+
+    const auto metrics = QFontMetrics{ font };
+    auto width = 0;
+    for (const auto& line : lines)
+        width = std::max(width, metrics.horizontalAdvance(line));
+
+    const auto lineHeight = metrics.lineSpacing();
+    const auto box = QRect{ margin, margin, width + 2 * margin, toInt(lines.size()) * lineHeight + 2 * margin };
+    painter.fillRect(box, QColor::fromRgba(backgroundColor));
+
+    painter.setPen(QColor::fromRgba(textColor));
+    for (std::size_t i = 0; i < lines.size(); ++i)
+    {
+        const auto lineRect = QRect{ 2 * margin, 2 * margin + toInt(i) * lineHeight, width, lineHeight };
+        painter.drawText(lineRect, Qt::AlignLeft | Qt::AlignVCenter, lines[i]);
+    }
+}
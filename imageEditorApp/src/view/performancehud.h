@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cachestats.h>
+#include "framestats.h"
+
+#include <optional>
+#include <QColor>
+#include <QPainter>
+
+// PerformanceHud: The overlay that shows what the display costs, drawn with a QPainter over the finished frame.
+//                 Besides the frame statistics, it shows the texture memory in use, how well the texture cache
+//                 works, how well the tiles of a virtual texture are cached, and how long the last merge of the
+//                 layers and the last readback of the display took.
+//                 While it is disabled, nothing is formatted or drawn, only the times of the merges and
+//                 readbacks are remembered.
+class PerformanceHud
+{
+public:
+    static const QRgb backgroundColor;
+    static const QRgb textColor;
+    static const int  margin;
+
+    auto isEnabled() const -> bool                { return enabled; }
+    void setEnabled(bool enable)                  { enabled = enable; }
+
+    // in milliseconds
+    void setMergeTime(double time)                { mergeTime = time; }
+    void setReadbackTime(double time)             { readbackTime = time; }
+
+    // the tiles only for a background that is shown through a virtual texture
+    void draw(QPainter& painter, const FrameStats& stats, qint64 textureMemory, const CacheStats& textureCache,
+              const std::optional<CacheStats>& tiles) const;
+
+private:
+    bool                  enabled{ false };
+    std::optional<double> mergeTime;
+    std::optional<double> readbackTime;
+};
@@ -0,0 +1,81 @@
+#include "recentfileswidget.h"
+
+#include <QFileInfo>
+#include <QIcon>
+#include <QPixmap>
+
+const int RecentFilesWidget::iconSize{ 64 };
+
+namespace
+{
+    const std::size_t queueCapacity{ 64u };
+    const int         filePathRole{ Qt::UserRole };
+}
+
+RecentFilesWidget::RecentFilesWidget(ThumbnailLoader loader, QWidget* parent)
+    : QWidget{ parent }
+    , layout{ new QVBoxLayout{ this }}
+    , listWidget{ new QListWidget{ this }}
+    , loader{ std::move(loader) }
+    , requests{ queueCapacity }
+    , worker{ &RecentFilesWidget::loadThumbnails, this }
+{
+    listWidget->setIconSize({ iconSize, iconSize });
+    listWidget->setUniformItemSizes(true);
+    layout->addWidget(listWidget);
+
+    connect(listWidget, &QListWidget::itemActivated, this, [this](QListWidgetItem* item) {
+        emit fileSelected(item->data(filePathRole).toString());
+    });
+}
+
+RecentFilesWidget::~RecentFilesWidget()
+{
+    ++generation;
+    requests.close();
+    worker.join();
+}
+
+void RecentFilesWidget::setFiles(const QStringList& files)
+{
+    const auto current = ++generation;
+
+    listWidget->clear();
+    for (const auto& file : files)
+    {
+        auto item = new QListWidgetItem{ QFileInfo{ file }.fileName(), listWidget };
+        item->setToolTip(file);
+        item->setData(filePathRole, file);
+
+        requests.push({ file, current });
+    }
+}
+
+// runs on the worker thread
+void RecentFilesWidget::loadThumbnails()
+{
+    while (auto request = requests.pop())
+    {
+        if (request->generation != generation)
+            continue;
+
+        const auto thumbnail = loader(request->filePath);
+        if (!thumbnail)
+            continue;
+
+        // pixmaps can only be created on the GUI thread, queued calls to a deleted widget are dropped by Qt
+        QMetaObject::invokeMethod(this, [this, filePath = request->filePath, img = *thumbnail] {
+            setThumbnail(filePath, img);
+        }, Qt::QueuedConnection);
+    }
+}
+
+void RecentFilesWidget::setThumbnail(const QString& filePath, const QImage& thumbnail)
+{
+    for (int i = 0; i < listWidget->count(); ++i)
+    {
+        const auto item = listWidget->item(i);
+        if (item->data(filePathRole).toString() == filePath)
+            item->setIcon(QIcon{ QPixmap::fromImage(thumbnail) });
+    }
+}
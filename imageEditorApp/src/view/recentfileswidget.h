@@ -0,0 +1,49 @@
+#pragma once
+
+#include <util.h>
+
+#include <atomic>
+#include <functional>
+#include <optional>
+#include <thread>
+#include <QImage>
+#include <QListWidget>
+#include <QStringList>
+#include <QVBoxLayout>
+
+// RecentFilesWidget: Lists the recently used files with their thumbnails.
+//                    The thumbnails are loaded by a background thread, and are filled in as they arrive,
+//                    requests for a list that has been replaced in the meantime are skipped.
+class RecentFilesWidget : public QWidget
+{
+    Q_OBJECT
+public:
+    using ThumbnailLoader = std::function<std::optional<QImage>(const QString&)>;
+
+    static const int iconSize;
+
+    explicit RecentFilesWidget(ThumbnailLoader loader, QWidget* parent = nullptr);
+    virtual ~RecentFilesWidget() override;
+
+    void setFiles(const QStringList& files);
+
+signals:
+    void fileSelected(const QString& filePath);
+
+private:
+    struct Request
+    {
+        QString  filePath;
+        unsigned generation;
+    };
+
+    QVBoxLayout* const            layout;
+    QListWidget* const            listWidget;
+    const ThumbnailLoader         loader;
+    util::blocking_queue<Request> requests;
+    std::atomic_uint              generation{ 0u };
+    std::thread                   worker;
+
+    void loadThumbnails();
+    void setThumbnail(const QString& filePath, const QImage& thumbnail);
+};
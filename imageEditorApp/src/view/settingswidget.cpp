@@ -14,9 +14,17 @@ SettingsWidget::SettingsWidget(IEditor::InterpMethod interpMethod, QWidget* pare
     , overlayColorLayout{ new QHBoxLayout }
     , overlayColorLabel{ new QLabel{ "Selection", this }}
     , overlayColorComboBox{ new QComboBox{ this }}      
+    , compressionLayout{ new QHBoxLayout }
+    , compressionLabel{ new QLabel{ "PNG compression", this }}
+    , compressionComboBox{ new QComboBox{ this }}
+    , mergeLayout{ new QHBoxLayout }
+    , mergeLabel{ new QLabel{ "Merge on", this }}
+    , mergeComboBox{ new QComboBox{ this }}
 {
     setupInterp(interpMethod);
     setupOverlayColor();
+    setupCompression();
+    setupMerge();
 }
 
 void SettingsWidget::setupInterp(IEditor::InterpMethod method)
@@ -63,6 +71,47 @@ void SettingsWidget::setupOverlayColor()
     });
 }
 
+void SettingsWidget::setupCompression()
+{
+    compressionComboBox->addItem("Fast");
+    compressionComboBox->addItem("Balanced");
+    compressionComboBox->addItem("Small");
+
+    compressionComboBox->setCurrentIndex(CompressionIndex::BALANCED);
+
+    compressionLayout->addWidget(compressionLabel);
+    compressionLayout->addWidget(compressionComboBox);
+
+    layout->addRow(compressionLayout);
+
+    connect(compressionComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int index) {
+        if (index < 0 || index >= CompressionIndex::COMPRESSION_COUNT)
+            return;
+
+        emit compressionChanged((CompressionIndex)index);
+    });
+}
+
+void SettingsWidget::setupMerge()
+{
+    mergeComboBox->addItem("CPU");
+    mergeComboBox->addItem("GPU");
+
+    mergeComboBox->setCurrentIndex(MergeIndex::CPU);
+
+    mergeLayout->addWidget(mergeLabel);
+    mergeLayout->addWidget(mergeComboBox);
+
+    layout->addRow(mergeLayout);
+
+    connect(mergeComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int index) {
+        if (index < 0 || index >= MergeIndex::MERGE_COUNT)
+            return;
+
+        emit mergeChanged((MergeIndex)index);
+    });
+}
+
 auto SettingsWidget::toInterpIndex(IEditor::InterpMethod method) const -> std::optional<InterpIndex>
 {
     switch (method)
@@ -77,4 +126,6 @@ void SettingsWidget::clearFocus()
 {
     interpComboBox->clearFocus();
     overlayColorComboBox->clearFocus();
+    compressionComboBox->clearFocus();
+    mergeComboBox->clearFocus();
 }
@@ -15,6 +15,8 @@ class SettingsWidget : public QWidget, public virtual IEditableWidget
     Q_OBJECT
 public:
     enum InterpIndex { NEAREST = 0, BILINEAR = 1, COUNT };
+    enum CompressionIndex { FAST = 0, BALANCED = 1, SMALL = 2, COMPRESSION_COUNT };
+    enum MergeIndex { CPU = 0, GPU = 1, MERGE_COUNT };
 
     explicit SettingsWidget(IEditor::InterpMethod interpMethod, QWidget* parent = nullptr);
 
@@ -27,6 +29,8 @@ public:
 signals:
     void interpChanged(InterpIndex index);
     void overlayColorChanged(const QString& msg);
+    void compressionChanged(CompressionIndex index);
+    void mergeChanged(MergeIndex index);
 
 private:
     QFormLayout* const layout;
@@ -39,6 +43,16 @@ private:
     QLabel* const      overlayColorLabel;
     QComboBox* const   overlayColorComboBox;    
 
+    QHBoxLayout* const compressionLayout;
+    QLabel* const      compressionLabel;
+    QComboBox* const   compressionComboBox;
+
+    QHBoxLayout* const mergeLayout;
+    QLabel* const      mergeLabel;
+    QComboBox* const   mergeComboBox;
+
     void setupInterp(IEditor::InterpMethod method);
     void setupOverlayColor();
+    void setupCompression();
+    void setupMerge();
 };
@@ -0,0 +1,233 @@
+#include "texturestreamer.h"
+#include <logger.h>
+#include <openglexception.h>
+#include <util.h>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace util::types;
+
+const std::size_t TextureStreamer::ringSize{ 3u };
+const int         TextureStreamer::sliceBytes{ 4 * 1024 * 1024 };
+
+TextureStreamer::TextureStreamer(std::function<void()> filled)
+    : filled{ std::move(filled) }
+    , buffers(ringSize)
+{
+    initializeOpenGLFunctions();
+
+    for (auto& buffer : buffers)
+    {
+        if (!buffer.pbo.create())
+            throw OpenGLException{ "Failed to create pixel buffer! "
+                                   "(This OpenGL implementation does not support pixel buffer objects)" };
+
+        buffer.pbo.setUsagePattern(QOpenGLBuffer::StreamDraw);
+    }
+
+    worker = std::thread{ &TextureStreamer::work, this };
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    cancel();
+
+    {
+        auto lock = std::lock_guard<std::mutex>{ mutex };
+        stopping = true;
+    }
+
+    changed.notify_all();
+    worker.join();
+}
+
+void TextureStreamer::start(QOpenGLTexture& texture, const QImage& image)
+{
+    cancel();
+
+    if (image.isNull())
+        return;
+
+    this->texture = &texture;
+    this->image   = image;
+    rowsPerSlice  = std::max(1, sliceBytes / image.bytesPerLine());
+    nextRow       = 0;
+    uploadedRows  = 0;
+    timer.start();
+
+    poll();
+}
+
+auto TextureStreamer::poll() -> bool
+{
+    if (!texture)
+        return true;
+
+    // the slices may arrive out of order, which does not matter, since each goes to its own rows
+    for (auto index : buffersIn(State::FILLED))
+        upload(buffers[index]);
+
+    for (auto index : buffersIn(State::FREE))
+        if (nextRow < image.height())
+            schedule(buffers[index], index);
+
+    if (uploadedRows < image.height())
+        return false;
+
+    Logger::debug("Streamed " + QString::number(image.sizeInBytes() / 1024) + " KiB of texture data in " +
+                  QString::number(timer.elapsed()) + " ms");
+
+    texture = nullptr;
+    image   = QImage{};
+    return true;
+}
+
+void TextureStreamer::finish()
+{
+    // a slice whose buffer could not be mapped is uploaded by poll itself, and leaves nothing to wait for
+    while (!poll())
+    {
+        auto lock = std::unique_lock<std::mutex>{ mutex };
+        changed.wait(lock, [this] {
+            return std::any_of(buffers.begin(), buffers.end(), [](const Buffer& b) { return b.state == State::FILLED; }) ||
+                   std::none_of(buffers.begin(), buffers.end(), [](const Buffer& b) { return b.state == State::FILLING; });
+        });
+    }
+}
+
+void TextureStreamer::cancel()
+{
+    {
+        auto lock = std::unique_lock<std::mutex>{ mutex };
+        jobs.clear();
+
+        // the slice being copied right now still writes into its buffer
+        changed.wait(lock, [this] { return !copying; });
+    }
+
+    for (auto& buffer : buffers)
+    {
+        if (buffer.state == State::FREE)
+            continue;
+
+        buffer.pbo.bind();
+        buffer.pbo.unmap();
+        buffer.pbo.release();
+        buffer.state = State::FREE;
+    }
+
+    texture = nullptr;
+    image   = QImage{};
+}
+
+auto TextureStreamer::buffersIn(State state) -> std::vector<std::size_t>
+{
+    auto lock = std::lock_guard<std::mutex>{ mutex };
+
+    auto result = std::vector<std::size_t>{};
+    for (std::size_t i = 0; i < buffers.size(); ++i)
+        if (buffers[i].state == state)
+            result.push_back(i);
+
+    return result;
+}
+
+void TextureStreamer::schedule(Buffer& buffer, std::size_t index)
+{
+    const auto rows  = std::min(rowsPerSlice, image.height() - nextRow);
+    const auto bytes = rows * image.bytesPerLine();
+
+    // reallocating orphans the storage the driver may still be reading from, instead of waiting for it
+    buffer.pbo.bind();
+    buffer.pbo.allocate(bytes);
+    const auto target = static_cast<uchar*>(buffer.pbo.map(QOpenGLBuffer::WriteOnly));
+    buffer.pbo.release();
+
+    if (!target)
+    {
+        Logger::warning("Failed to map a pixel buffer, uploading the slice directly");
+        uploadFromImage(nextRow, rows);
+        nextRow += rows;
+        return;
+    }
+
+    buffer.firstRow = nextRow;
+    buffer.rows     = rows;
+
+    {
+        auto lock = std::lock_guard<std::mutex>{ mutex };
+        buffer.state = State::FILLING;
+        jobs.push_back({ index, target, image.constScanLine(nextRow), std::size_t(bytes) });
+    }
+
+    changed.notify_all();
+    nextRow += rows;
+}
+
+// the rows are QImage::Format_ARGB32, i.e. every pixel is a native 32 bit 0xAARRGGBB word, which is exactly
+// what GL_BGRA with GL_UNSIGNED_INT_8_8_8_8_REV describes, on hosts of either byte order
+void TextureStreamer::upload(Buffer& buffer)
+{
+    buffer.pbo.bind();
+    buffer.pbo.unmap();
+
+    // with a pixel unpack buffer bound, the data pointer is an offset into the buffer
+    texture->bind();
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, buffer.firstRow, image.width(), buffer.rows,
+                    GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, nullptr);
+
+    buffer.pbo.release();
+    uploadedRows  += buffer.rows;
+    uploadedBytes += qint64{ buffer.rows } * image.bytesPerLine();
+
+    auto lock = std::lock_guard<std::mutex>{ mutex };
+    buffer.state = State::FREE;
+}
+
+void TextureStreamer::uploadFromImage(int firstRow, int rows)
+{
+    texture->bind();
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, firstRow, image.width(), rows,
+                    GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, image.constScanLine(firstRow));
+
+    uploadedRows  += rows;
+    uploadedBytes += qint64{ rows } * image.bytesPerLine();
+}
+
+auto TextureStreamer::takeUploadedBytes() -> qint64
+{
+    const auto bytes = uploadedBytes;
+    uploadedBytes = 0;
+
+    return bytes;
+}
+
+void TextureStreamer::work()
+{
+    auto lock = std::unique_lock<std::mutex>{ mutex };
+
+    while (true)
+    {
+        changed.wait(lock, [this] { return stopping || !jobs.empty(); });
+        if (stopping)
+            return;
+
+        const auto job = jobs.front();
+        jobs.pop_front();
+        copying = true;
+
+        // the rows of the image are contiguous, so a slice is a single copy
+        lock.unlock();
+        std::memcpy(job.target, job.source, job.bytes);
+        lock.lock();
+
+        copying = false;
+        buffers[job.buffer].state = State::FILLED;
+        changed.notify_all();
+
+        lock.unlock();
+        filled();
+        lock.lock();
+    }
+}
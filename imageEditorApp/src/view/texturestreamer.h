@@ -0,0 +1,92 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QOpenGLBuffer>
+#include <QOpenGLFunctions>
+#include <QOpenGLTexture>
+
+// TextureStreamer: Uploads an image into a texture without stalling the GUI thread. The image is cut
+//                  into slices of rows, which are staged through a ring of pixel buffer objects: the GUI
+//                  thread maps a free buffer, a worker thread copies the next slice into it, and once it
+//                  is filled, the GUI thread unmaps it and lets the driver copy it into the texture.
+//                  Apart from the constructor, every function expects the GL context to be current.
+class TextureStreamer : protected QOpenGLFunctions
+{
+public:
+    static const std::size_t ringSize;
+    static const int         sliceBytes;
+
+    // filled is called from the worker thread whenever a buffer is ready to be uploaded
+    explicit TextureStreamer(std::function<void()> filled);
+    ~TextureStreamer();
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    // cancels the current upload, texture must have storage allocated for the size of image
+    void start(QOpenGLTexture& texture, const QImage& image);
+
+    // uploads the filled buffers and hands the free ones to the worker,
+    // returns true once the whole image is in the texture
+    auto poll() -> bool;
+
+    // blocks until the whole image is in the texture
+    void finish();
+
+    // stops the current upload, the texture is left partially filled
+    void cancel();
+
+    // the bytes handed to the driver since the last call
+    auto takeUploadedBytes() -> qint64;
+
+private:
+    enum class State { FREE, FILLING, FILLED };
+
+    struct Buffer
+    {
+        QOpenGLBuffer pbo{ QOpenGLBuffer::PixelUnpackBuffer };
+        State         state{ State::FREE };
+        int           firstRow{ 0 };
+        int           rows{ 0 };
+    };
+
+    struct Job
+    {
+        std::size_t  buffer;
+        uchar*       target;
+        const uchar* source;
+        std::size_t  bytes;
+    };
+
+    std::function<void()>   filled;
+    std::vector<Buffer>     buffers;
+
+    // the image is kept, so that the worker can read its pixels even if the caller modifies its own copy
+    QOpenGLTexture*         texture{ nullptr };
+    QImage                  image;
+    int                     rowsPerSlice{ 0 };
+    int                     nextRow{ 0 };
+    int                     uploadedRows{ 0 };
+    qint64                  uploadedBytes{ 0 };
+    QElapsedTimer           timer;
+
+    std::mutex              mutex;
+    std::condition_variable changed;
+    std::deque<Job>         jobs;
+    bool                    copying{ false };
+    bool                    stopping{ false };
+    std::thread             worker;
+
+    auto buffersIn(State state) -> std::vector<std::size_t>;
+    void schedule(Buffer& buffer, std::size_t index);
+    void upload(Buffer& buffer);
+    void uploadFromImage(int firstRow, int rows);
+    void work();
+};
@@ -22,10 +22,12 @@ QMAKE_CXXFLAGS += -isystem "$$[QT_INSTALL_HEADERS]" -isystem "$$[QT_INSTALL_HEAD
                   -Wno-double-promotion # turn these warnings off
                   
 TEMPLATE = app
-QT += core
+QT += core gui opengl
+LIBS += -lz
 
 TEMPLATE = app
 TARGET = imageEditorTests
+DEFINES += CATCH_CONFIG_ENABLE_BENCHMARKING # benchmarks are hidden, run them with "[benchmark]"
 DESTDIR = release
 OBJECTS_DIR = release/.obj
 MOC_DIR = release/.moc
@@ -34,8 +36,11 @@ INCLUDEPATH += ../imageEditorApp/src/common \
                ../imageEditorApp/src/persistence
 HEADERS += $$files(../imageEditorApp/src/common/*.h) \
            $$files(../imageEditorApp/src/model/*.h) \
-           $$files(../imageEditorApp/src/persistence/*.h)
+           $$files(../imageEditorApp/src/persistence/*.h) \
+           $$files(../imageEditorApp/src/render/*.h) \
+           $$files(tests/*.h)
 SOURCES += $$files(../imageEditorApp/src/common/*.cpp) \
            $$files(../imageEditorApp/src/model/*.cpp) \
            $$files(../imageEditorApp/src/persistence/*.cpp) \
+           $$files(../imageEditorApp/src/render/*.cpp) \
            $$files(tests/*.cpp)
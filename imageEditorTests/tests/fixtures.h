@@ -0,0 +1,49 @@
+#pragma once
+
+#include <offscreencontext.h>
+
+#include <memory>
+#include <QGuiApplication>
+#include <QImage>
+
+// the fixtures that the tests of several modules share
+namespace fixture
+{
+    // offscreen contexts need a GUI application, which the test runner does not create; without a display
+    // it runs on the offscreen platform, and asks Mesa for its software rasterizer
+    inline void makeApplication()
+    {
+        static auto argc   = 1;
+        static char name[] = "imageEditorTests";
+        static char* argv[]{ name, nullptr };
+
+        if (QCoreApplication::instance())
+            return;
+
+        if (qEnvironmentVariableIsEmpty("DISPLAY") && qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+        if (qEnvironmentVariableIsEmpty("LIBGL_ALWAYS_SOFTWARE"))
+            qputenv("LIBGL_ALWAYS_SOFTWARE", "1");
+
+        QCoreApplication::setAttribute(Qt::AA_UseSoftwareOpenGL);
+        static auto app = QGuiApplication{ argc, argv };
+    }
+
+    // null if no OpenGL implementation is available, the tests that need one skip themselves then
+    inline auto makeContext() -> std::unique_ptr<OffscreenContext>
+    {
+        makeApplication();
+        return OffscreenContext::create();
+    }
+
+    // smooth enough for the bilinear filters to matter, with some noise that tells neighbouring pixels apart
+    inline auto makeImage(int width, int height, int seed = 0) -> QImage
+    {
+        auto img = QImage{ width, height, QImage::Format_ARGB32 };
+        for (int y = 0; y < height; ++y)
+            for (int x = 0; x < width; ++x)
+                img.setPixel(x, y, qRgba((x * 255) / width, (y * 255) / height, ((x ^ y) * 7 + seed * 50) & 0xff, 0xff));
+
+        return img;
+    }
+}
@@ -0,0 +1,141 @@
+#include "catch.hpp"
+#include <colorengine.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace
+{
+    // every combination of a coarse grid of channel values, with varying alpha
+    auto makeImage() -> QImage
+    {
+        auto img = QImage{ 18 * 18, 18, QImage::Format_ARGB32 };
+        for (int r = 0; r < 18; ++r)
+            for (int g = 0; g < 18; ++g)
+                for (int b = 0; b < 18; ++b)
+                    img.setPixel(r * 18 + g, b, qRgba(r * 15, g * 15, b * 15, (r * 37 + b) & 0xff));
+
+        return img;
+    }
+}
+
+TEST_CASE("Test color engine", "[model/colorengine]")
+{
+    SECTION("Test default values")
+    {
+        auto img = QImage{ 4, 4, QImage::Format_ARGB32 };
+        img.fill(qRgba(10, 120, 240, 200));
+
+        REQUIRE(ColorEngine::isIdentity(ColorData{}));
+        REQUIRE(ColorEngine::apply(img, ColorData{}) == img);
+    }
+    SECTION("Test gray stays gray")
+    {
+        const auto pixel = ColorEngine::applyPixel(qRgb(100, 100, 100), ColorData{ 0.5f, 0.5f, 0.5f, 0.1f, 1.2f });
+
+        CHECK(std::abs(qRed(pixel) - qGreen(pixel)) <= 1);
+        CHECK(std::abs(qGreen(pixel) - qBlue(pixel)) <= 1);
+    }
+    SECTION("Test brightness")
+    {
+        auto data = ColorData{};
+        data.bright = 0.2f;
+
+        const auto pixel = ColorEngine::applyPixel(qRgb(100, 100, 100), data);
+
+        CHECK(qRed(pixel) == Approx(151).margin(2));
+        CHECK(qGreen(pixel) == Approx(151).margin(2));
+        CHECK(qBlue(pixel) == Approx(151).margin(2));
+    }
+    SECTION("Test zero contrast")
+    {
+        auto data = ColorData{};
+        data.contrast = 0.0f;
+
+        const auto pixel = ColorEngine::applyPixel(qRgb(30, 200, 90), data);
+
+        CHECK(qRed(pixel) == Approx(128).margin(2));
+        CHECK(qGreen(pixel) == Approx(128).margin(2));
+        CHECK(qBlue(pixel) == Approx(128).margin(2));
+    }
+    SECTION("Test alpha is kept")
+    {
+        auto data = ColorData{};
+        data.red = 0.8f;
+
+        REQUIRE(qAlpha(ColorEngine::applyPixel(qRgba(50, 50, 50, 77), data)) == 77);
+    }
+}
+
+TEST_CASE("Test color engine lookup tables match the curves", "[model/colorengine]")
+{
+    const auto img = makeImage();
+
+    for (const auto& data : { ColorData{ 0.3f, 0.5f, 0.8f, 0.1f, 1.7f }, ColorData{ 0.9f, 0.2f, 0.5f, -0.2f, 0.6f },
+                              ColorData{ 0.5f, 0.6f, 0.4f, 0.0f, 3.0f }, ColorData{ 0.2f, 0.5f, 0.5f, 0.0f, 1.0f } })
+    {
+        SECTION("Contrast " + std::to_string(data.contrast) + ", bright " + std::to_string(data.bright))
+        {
+            const auto result = ColorEngine::apply(img, data);
+            REQUIRE(result.size() == img.size());
+
+            // the interpolation of the contrast curve may round a channel the other way
+            auto worst = 0;
+            for (int y = 0; y < img.height(); ++y)
+            {
+                for (int x = 0; x < img.width(); ++x)
+                {
+                    const auto expected = ColorEngine::applyPixel(img.pixel(x, y), data);
+                    const auto actual   = result.pixel(x, y);
+
+                    REQUIRE(qAlpha(actual) == qAlpha(expected));
+                    worst = std::max({ worst, std::abs(qRed(expected) - qRed(actual)),
+                                       std::abs(qGreen(expected) - qGreen(actual)),
+                                       std::abs(qBlue(expected) - qBlue(actual)) });
+                }
+            }
+
+            CHECK(worst <= 1);
+        }
+    }
+}
+
+TEST_CASE("Test color engine grayscale", "[model/colorengine]")
+{
+    auto img = QImage{ 3, 1, QImage::Format_ARGB32 };
+    img.setPixel(0, 0, qRgba(255, 0, 0, 255));
+    img.setPixel(1, 0, qRgba(10, 120, 240, 90));
+    img.setPixel(2, 0, qRgba(255, 255, 255, 255));
+
+    const auto result = ColorEngine::grayscale(img);
+
+    CHECK(result.pixel(0, 0) == qRgba(76, 76, 76, 255));
+    CHECK(result.pixel(1, 0) == qRgba(101, 101, 101, 90));
+    CHECK(result.pixel(2, 0) == qRgba(255, 255, 255, 255));
+}
+
+TEST_CASE("Benchmark color engine", "[.][benchmark][model/colorengine]")
+{
+    auto img = QImage{ 4096, 4096, QImage::Format_ARGB32 };
+    for (int y = 0; y < img.height(); ++y)
+        for (int x = 0; x < img.width(); ++x)
+            img.setPixel(x, y, qRgb(x & 0xff, y & 0xff, (x ^ y) & 0xff));
+
+    const auto data = ColorData{ 0.3f, 0.5f, 0.8f, 0.1f, 1.7f };
+
+    BENCHMARK("Apply 4096x4096, all color stages")
+    {
+        return ColorEngine::apply(img, data);
+    };
+
+    BENCHMARK("Apply 4096x4096, brightness only")
+    {
+        return ColorEngine::apply(img, ColorData{ 0.5f, 0.5f, 0.5f, 0.1f, 1.0f });
+    };
+
+    BENCHMARK("Grayscale 4096x4096")
+    {
+        return ColorEngine::grayscale(img);
+    };
+}
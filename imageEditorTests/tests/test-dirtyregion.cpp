@@ -0,0 +1,67 @@
+#include <catch.hpp>
+#include <dirtyregion.h>
+
+TEST_CASE("Test dirty region", "[common/dirtyregion]")
+{
+    auto region = DirtyRegion{ QRect{ 0, 0, 1000, 1000 } };
+
+    SECTION("Rectangles are clipped to the bounds")
+    {
+        region.add(QRect{ -50, 950, 100, 100 });
+        REQUIRE(region.getRects().size() == 1u);
+        CHECK(region.getRects().front() == QRect{ 0, 950, 50, 50 });
+
+        region.add(QRect{ 2000, 2000, 10, 10 });
+        CHECK(region.getRects().size() == 1u);
+    }
+    SECTION("Only the changed area is dirty")
+    {
+        region.add(QRect{ 100, 100, 100, 100 });
+        CHECK(region.getArea() == 100 * 100);
+    }
+    SECTION("Contained rectangles are dropped")
+    {
+        region.add(QRect{ 100, 100, 100, 100 });
+        region.add(QRect{ 120, 120, 10, 10 });
+        CHECK(region.getRects().size() == 1u);
+        CHECK(region.getArea() == 100 * 100);
+    }
+    SECTION("Adjacent rectangles are merged")
+    {
+        region.add(QRect{ 0, 0, 100, 50 });
+        region.add(QRect{ 0, 50, 100, 50 });
+        REQUIRE(region.getRects().size() == 1u);
+        CHECK(region.getRects().front() == QRect{ 0, 0, 100, 100 });
+    }
+    SECTION("Distant rectangles are kept apart")
+    {
+        region.add(QRect{ 0, 0, 10, 10 });
+        region.add(QRect{ 900, 900, 10, 10 });
+        CHECK(region.getRects().size() == 2u);
+        CHECK(region.getArea() == 200);
+    }
+    SECTION("The number of rectangles is limited")
+    {
+        for (int i = 0; i < 100; ++i)
+            region.add(QRect{ (i % 10) * 100, (i / 10) * 100, 5, 5 });
+
+        CHECK(region.getRects().size() <= DirtyRegion::maxRects);
+
+        // every added rectangle is still covered
+        for (int i = 0; i < 100; ++i)
+        {
+            const auto rect = QRect{ (i % 10) * 100, (i / 10) * 100, 5, 5 };
+            auto covered = false;
+            for (const auto& r : region.getRects())
+                covered = covered || r.contains(rect);
+
+            CHECK(covered);
+        }
+    }
+    SECTION("Take empties the region")
+    {
+        region.add(QRect{ 0, 0, 10, 10 });
+        CHECK(region.take().size() == 1u);
+        CHECK(region.isEmpty());
+    }
+}
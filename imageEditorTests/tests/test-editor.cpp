@@ -0,0 +1,77 @@
+#include <catch.hpp>
+#include <editorfactory.h>
+
+#include <QTransform>
+
+namespace
+{
+    // every pixel is different, so a rotation in the wrong direction or about the wrong center is caught
+    auto makeImage(int width, int height) -> QImage
+    {
+        auto img = QImage{ width, height, QImage::Format_ARGB32 };
+        for (int y = 0; y < height; ++y)
+            for (int x = 0; x < width; ++x)
+                img.setPixel(x, y, qRgba(x * 20, y * 20, (x * 7 + y * 13) & 0xff, 0xff));
+
+        return img;
+    }
+
+    // the way the batch mode rotates, on an image whose rows are in GL order, as the editor keeps them
+    auto rotateLikeBatch(IEditor& editor, const QImage& displayed, float angle) -> QImage
+    {
+        const auto img = displayed.mirrored();
+
+        auto background = QImage{ img.size(), img.format() };
+        background.fill(Qt::black);
+
+        return editor.mergeImages(background, img, img.rect(), angle).mirrored();
+    }
+}
+
+// the display keeps the texture of an image as long as its cache key does not change, see DisplayWidget
+TEST_CASE("Test merging leaves the lower image intact", "[model/editor]")
+{
+    auto editor = fact::makeEditor(IEditor::InterpMethod::NEAREST, false);
+
+    auto lower = QImage{ 16, 16, QImage::Format_ARGB32 };
+    lower.fill(Qt::black);
+    const auto shown = lower;
+    const auto pixels = lower.copy();
+
+    auto upper = QImage{ 4, 4, QImage::Format_ARGB32 };
+    upper.fill(Qt::white);
+
+    const auto merged = editor->mergeImages(lower, upper, QRect{ 6, 6, 4, 4 }, 0.0f);
+
+    CHECK(merged.pixel(7, 7) == qRgba(0xff, 0xff, 0xff, 0xff));
+    CHECK(merged.cacheKey() != shown.cacheKey());
+    CHECK(shown == pixels);
+    CHECK(lower == pixels);
+}
+
+TEST_CASE("Test rotation direction", "[model/editor]")
+{
+    auto editor = fact::makeEditor(IEditor::InterpMethod::NEAREST, false);
+
+    // odd sides, so that the center is a pixel and right angles map pixels exactly onto pixels
+    const auto displayed = makeImage(9, 9);
+
+    SECTION("Positive angles rotate counter-clockwise on screen")
+    {
+        auto marked = QImage{ 9, 9, QImage::Format_ARGB32 };
+        marked.fill(Qt::black);
+        marked.setPixel(8, 2, qRgba(0xff, 0x00, 0x00, 0xff));
+
+        // right of the center and a little above it, turned a quarter counter-clockwise, is above and to the left
+        const auto rotated = rotateLikeBatch(*editor, marked, 90.0f);
+        CHECK(rotated.pixel(2, 0) == qRgba(0xff, 0x00, 0x00, 0xff));
+        CHECK(rotated.pixel(8, 2) == qRgba(0x00, 0x00, 0x00, 0xff));
+    }
+    SECTION("Right angles match a plain rotation of the image")
+    {
+        // QTransform rotates clockwise on screen, since its y axis points down; its exact right angles are positive
+        for (const auto angle : { 90.0f, 180.0f, 270.0f })
+            CHECK(rotateLikeBatch(*editor, displayed, angle) ==
+                  displayed.transformed(QTransform{}.rotate(360.0 - double(angle))));
+    }
+}
@@ -0,0 +1,97 @@
+#include <catch.hpp>
+#include <editorfactory.h>
+#include "fixtures.h"
+#include <gpumerger.h>
+
+#include <cstdlib>
+#include <memory>
+
+namespace
+{
+    auto makeMerger() -> std::unique_ptr<GpuMerger>
+    {
+        fixture::makeApplication();
+        return GpuMerger::create();
+    }
+
+    // the share of the pixels with a channel that differs by more than tolerance
+    auto mismatchRatio(const QImage& a, const QImage& b, int tolerance) -> double
+    {
+        auto mismatches = 0;
+        for (int y = 0; y < a.height(); ++y)
+        {
+            for (int x = 0; x < a.width(); ++x)
+            {
+                const auto p = a.pixel(x, y), q = b.pixel(x, y);
+                if (std::abs(qRed(p) - qRed(q)) > tolerance || std::abs(qGreen(p) - qGreen(q)) > tolerance ||
+                    std::abs(qBlue(p) - qBlue(q)) > tolerance || std::abs(qAlpha(p) - qAlpha(q)) > tolerance)
+                    ++mismatches;
+            }
+        }
+
+        return double(mismatches) / double(a.width() * a.height());
+    }
+}
+
+// needs an OpenGL implementation, a software one will do; run it with "[gpu]"
+TEST_CASE("Test GPU merge matches the CPU merge", "[.][gpu][model/gpumerger]")
+{
+    const auto merger = makeMerger();
+    if (!merger)
+    {
+        WARN("No OpenGL context is available");
+        return;
+    }
+
+    auto editor = fact::makeEditor(IEditor::InterpMethod::NEAREST, false);
+
+    const auto lower = fixture::makeImage(96, 64, 0);
+    const auto upper = fixture::makeImage(40, 30, 1);
+    const auto rect  = QRect{ QPoint{ 20, 12 }, upper.size() };
+
+    for (const auto method : { IEditor::InterpMethod::NEAREST, IEditor::InterpMethod::BILINEAR })
+    {
+        for (const auto angle : { 0.0f, 30.0f, 90.0f, 217.5f })
+        {
+            SECTION("Method " + std::to_string(method) + ", angle " + std::to_string(angle))
+            {
+                editor->setInterpolationMethod(method);
+
+                const auto cpu = editor->mergeImages(lower, upper, rect, angle);
+                const auto gpu = merger->merge(lower, upper, rect, angle, method);
+
+                REQUIRE(gpu);
+                REQUIRE(gpu->size() == cpu.size());
+
+                // rounding differs a little, and a few pixels on the edges of the rotated rect may go either way
+                CHECK(mismatchRatio(cpu, *gpu, 2) < 0.01);
+            }
+        }
+    }
+}
+
+TEST_CASE("Benchmark GPU merge", "[.][benchmark][model/gpumerger]")
+{
+    const auto merger = makeMerger();
+    if (!merger)
+    {
+        WARN("No OpenGL context is available");
+        return;
+    }
+
+    auto editor = fact::makeEditor(IEditor::InterpMethod::BILINEAR, false);
+
+    const auto lower = fixture::makeImage(2048, 2048, 0);
+    const auto upper = fixture::makeImage(1024, 1024, 1);
+    const auto rect  = QRect{ QPoint{ 512, 512 }, upper.size() };
+
+    BENCHMARK("CPU merge 2048x2048, bilinear")
+    {
+        return editor->mergeImages(lower, upper, rect, 30.0f);
+    };
+
+    BENCHMARK("GPU merge 2048x2048, bilinear")
+    {
+        return merger->merge(lower, upper, rect, 30.0f, IEditor::InterpMethod::BILINEAR);
+    };
+}
@@ -0,0 +1,123 @@
+#include <catch.hpp>
+#include <imagecache.h>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <QTemporaryDir>
+
+namespace
+{
+    auto makeImage(int size, int seed) -> QImage
+    {
+        auto img = QImage{ size, size, QImage::Format_ARGB32 };
+        img.fill(qRgba(seed & 0xff, 0x40, 0x80, 0xff));
+        return img;
+    }
+
+    auto waitForPrefetch(const ImageCache& cache, std::size_t count) -> bool
+    {
+        for (int i = 0; i < 500 && cache.stats().prefetched < count; ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds{ 10 });
+
+        return cache.stats().prefetched >= count;
+    }
+}
+
+TEST_CASE("Test image cache", "[persistence/imagecache]")
+{
+    auto dir = QTemporaryDir{};
+    REQUIRE(dir.isValid());
+
+    auto paths = QStringList{};
+    for (int i = 0; i < 4; ++i)
+    {
+        paths.append(dir.filePath("image" + QString::number(i) + ".png"));
+        REQUIRE(makeImage(64, i).save(paths.last()));
+    }
+
+    // one image takes 64 * 64 * 4 bytes
+    const auto imageBytes = std::size_t(64 * 64 * 4);
+
+    SECTION("Hits and misses")
+    {
+        auto cache = ImageCache{};
+
+        const auto img = cache.get(paths[0]);
+        CHECK(img == ImageCache::decode(paths[0]));
+        CHECK(cache.get(paths[0]) == img);
+
+        const auto stats = cache.stats();
+        CHECK(stats.misses == 1u);
+        CHECK(stats.hits == 1u);
+        CHECK(stats.images == 1u);
+        CHECK(stats.bytes == imageBytes);
+        CHECK(stats.hitRate() == Approx(0.5));
+    }
+    SECTION("Editing a returned image leaves the cached one intact")
+    {
+        auto cache = ImageCache{};
+
+        // the cache hands out shallow copies, a write has to detach it from the cached data
+        auto img = cache.get(paths[0]);
+        auto data = reinterpret_cast<QRgb*>(img.bits());
+        std::fill(data, data + img.width() * img.height(), qRgba(0xff, 0xff, 0xff, 0xff));
+        img.setPixel(0, 0, qRgba(0x00, 0x00, 0x00, 0xff));
+
+        const auto cached = cache.get(paths[0]);
+        CHECK(cache.stats().hits == 1u);
+        CHECK(cached == ImageCache::decode(paths[0]));
+        CHECK(cached != img);
+        CHECK(cached.cacheKey() != img.cacheKey());
+    }
+    SECTION("Missing file")
+    {
+        auto cache = ImageCache{};
+
+        CHECK(cache.get(dir.filePath("missing.png")).isNull());
+        CHECK(cache.stats().images == 0u);
+    }
+    SECTION("Least recently used images are evicted")
+    {
+        auto cache = ImageCache{ 2u * imageBytes };
+
+        (void)cache.get(paths[0]);
+        (void)cache.get(paths[1]);
+        (void)cache.get(paths[0]);
+        (void)cache.get(paths[2]);
+
+        CHECK(cache.stats().images == 2u);
+        CHECK(cache.stats().bytes <= 2u * imageBytes);
+
+        (void)cache.get(paths[0]);
+        CHECK(cache.stats().hits == 2u);
+
+        (void)cache.get(paths[1]);
+        CHECK(cache.stats().misses == 4u);
+    }
+    SECTION("Prefetched images are hits")
+    {
+        auto cache = ImageCache{};
+
+        cache.prefetch({ paths[1], paths[2], paths[3] });
+        REQUIRE(waitForPrefetch(cache, 3u));
+
+        CHECK(cache.get(paths[2]) == ImageCache::decode(paths[2]));
+        CHECK(cache.get(paths[3]) == ImageCache::decode(paths[3]));
+        CHECK(cache.stats().hits == 2u);
+        CHECK(cache.stats().misses == 0u);
+    }
+    SECTION("Modified files are decoded again")
+    {
+        auto cache = ImageCache{};
+
+        (void)cache.get(paths[0]);
+
+        // make sure the modification time changes, even on file systems with a coarse resolution
+        std::this_thread::sleep_for(std::chrono::milliseconds{ 1100 });
+        REQUIRE(makeImage(64, 42).save(paths[0]));
+
+        CHECK(cache.get(paths[0]) == ImageCache::decode(paths[0]));
+        CHECK(cache.stats().misses == 2u);
+    }
+}
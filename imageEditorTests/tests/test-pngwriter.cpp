@@ -0,0 +1,93 @@
+#include <catch.hpp>
+#include <pngwriter.h>
+
+#include <QBuffer>
+#include <QTemporaryDir>
+
+namespace
+{
+    // large enough to be split into several chunks, with some noise so the filters differ between rows
+    auto makeImage(int width, int height, bool opaque) -> QImage
+    {
+        auto img = QImage{ width, height, QImage::Format_ARGB32 };
+        for (int y = 0; y < height; ++y)
+            for (int x = 0; x < width; ++x)
+                img.setPixel(x, y, qRgba(x & 0xff, (y * 3) & 0xff, ((x * y) >> 3) & 0xff, opaque ? 0xff : (x + y) & 0xff));
+
+        return img;
+    }
+
+    auto decode(const QByteArray& png) -> QImage
+    {
+        return QImage::fromData(png, "PNG").convertToFormat(QImage::Format_ARGB32);
+    }
+}
+
+TEST_CASE("Test PNG writer round trip", "[persistence/pngwriter]")
+{
+    for (const auto level : { 0, 1, 6, 9 })
+    {
+        SECTION("Level " + std::to_string(level))
+        {
+            const auto opaque = makeImage(700, 500, true);
+            const auto alpha  = makeImage(700, 500, false);
+
+            CHECK(decode(PngWriter::encode(opaque, level)) == opaque);
+            CHECK(decode(PngWriter::encode(alpha, level)) == alpha);
+        }
+    }
+}
+
+TEST_CASE("Test PNG writer", "[persistence/pngwriter]")
+{
+    SECTION("Single pixel")
+    {
+        const auto img = makeImage(1, 1, false);
+        CHECK(decode(PngWriter::encode(img, 6)) == img);
+    }
+    SECTION("Smaller than one chunk")
+    {
+        const auto img = makeImage(31, 17, true);
+        CHECK(decode(PngWriter::encode(img, 6)) == img);
+    }
+    SECTION("Higher levels are not larger")
+    {
+        const auto img = makeImage(700, 500, true);
+        CHECK(PngWriter::encode(img, 9).size() <= PngWriter::encode(img, 1).size());
+    }
+    SECTION("Null image")
+    {
+        CHECK(PngWriter::encode(QImage{}, 6).isEmpty());
+    }
+    SECTION("Write file")
+    {
+        auto dir = QTemporaryDir{};
+        REQUIRE(dir.isValid());
+
+        const auto path = dir.filePath("image.png");
+        const auto img  = makeImage(300, 200, false);
+
+        REQUIRE(PngWriter::write(path, img, 6));
+        CHECK(QImage{ path }.convertToFormat(QImage::Format_ARGB32) == img);
+    }
+}
+
+TEST_CASE("Benchmark PNG writer", "[.][benchmark][persistence/pngwriter]")
+{
+    const auto img = makeImage(4096, 4096, true);
+
+    for (const auto level : { 1, 6, 9 })
+    {
+        BENCHMARK("Encode 4096x4096, level " + std::to_string(level))
+        {
+            return PngWriter::encode(img, level);
+        };
+    }
+
+    BENCHMARK("Encode 4096x4096 with QImage for comparison")
+    {
+        auto buffer = QBuffer{};
+        buffer.open(QIODevice::WriteOnly);
+        return img.save(&buffer, "PNG");
+    };
+}
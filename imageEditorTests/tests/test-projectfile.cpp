@@ -0,0 +1,218 @@
+#include <catch.hpp>
+#include <projectfile.h>
+
+#include <algorithm>
+#include <QDataStream>
+#include <QFile>
+#include <QTemporaryDir>
+
+namespace
+{
+    // an image with a different value in every pixel, so misplaced tiles are caught
+    auto makeImage(int width, int height, int seed) -> QImage
+    {
+        auto img = QImage{ width, height, QImage::Format_ARGB32 };
+        for (int y = 0; y < height; ++y)
+            for (int x = 0; x < width; ++x)
+                img.setPixel(x, y, qRgba((x + seed) & 0xff, (y + seed) & 0xff, (x ^ y) & 0xff, 0xff));
+
+        return img;
+    }
+
+    // a project file whose index holds one image entry with the given size and tiles, and no pixels at all
+    void writeHostileFile(const QString& path, qint32 width, qint32 height, quint32 count, quint64 offset, quint32 length)
+    {
+        auto file = QFile{ path };
+        REQUIRE(file.open(QIODevice::WriteOnly));
+
+        auto stream = QDataStream{ &file };
+        stream.setVersion(QDataStream::Qt_5_12);
+        stream << ProjectFile::magic << ProjectFile::version;
+
+        const auto indexOffset = quint64(file.pos());
+        stream << quint32(1u) << quint32(0u) << width << height << count;
+        for (quint32 i = 0; i < std::min(count, 4u); ++i)
+            stream << offset << length;
+
+        stream << false << indexOffset << ProjectFile::magic;
+    }
+}
+
+TEST_CASE("Test project file round trip", "[persistence/projectfile]")
+{
+    auto dir = QTemporaryDir{};
+    REQUIRE(dir.isValid());
+    const auto path = dir.filePath("project.iep");
+
+    // sizes that are not multiples of the tile size, to have partial tiles on the edges
+    const auto history = std::vector<QImage>{ makeImage(600, 300, 0), makeImage(600, 300, 1), makeImage(257, 513, 2) };
+
+    auto layer = LayerState{};
+    layer.kind           = LayerState::CUT;
+    layer.image          = makeImage(40, 30, 3);
+    layer.sourcePosition = QRect{ 10, 20, 40, 30 };
+    layer.translate      = QVector3D{ 0.25f, -0.5f, 0.0f };
+    layer.rotate         = 45.0f;
+
+    REQUIRE(ProjectFile::write(path, history, 1u, layer));
+
+    const auto contents = ProjectFile::read(path);
+    REQUIRE(contents);
+    REQUIRE(contents->history.size() == history.size());
+    REQUIRE(contents->current == 1u);
+
+    SECTION("Only the current image is decoded on open")
+    {
+        CHECK(contents->history[1].isLoaded());
+        CHECK(!contents->history[0].isLoaded());
+        CHECK(!contents->history[2].isLoaded());
+    }
+    SECTION("Images are restored")
+    {
+        for (std::size_t i = 0; i < history.size(); ++i)
+            CHECK(contents->history[i].get() == history[i]);
+    }
+    SECTION("Layer state is restored")
+    {
+        REQUIRE(contents->layer);
+        CHECK(contents->layer->kind == LayerState::CUT);
+        CHECK(contents->layer->image == layer.image);
+        CHECK(contents->layer->sourcePosition == layer.sourcePosition);
+        CHECK(contents->layer->translate == layer.translate);
+        CHECK(contents->layer->rotate == layer.rotate);
+    }
+}
+
+TEST_CASE("Test project file without a layer", "[persistence/projectfile]")
+{
+    auto dir = QTemporaryDir{};
+    REQUIRE(dir.isValid());
+    const auto path = dir.filePath("project.iep");
+
+    REQUIRE(ProjectFile::write(path, { makeImage(16, 16, 0) }, 0u, std::nullopt));
+
+    const auto contents = ProjectFile::read(path);
+    REQUIRE(contents);
+    CHECK(!contents->layer);
+    CHECK(contents->history.front().get() == makeImage(16, 16, 0));
+}
+
+TEST_CASE("Test project file thumbnail", "[persistence/projectfile]")
+{
+    auto dir = QTemporaryDir{};
+    REQUIRE(dir.isValid());
+    const auto path = dir.filePath("project.iep");
+
+    SECTION("Large images are scaled down")
+    {
+        const auto current = makeImage(600, 300, 1);
+        REQUIRE(ProjectFile::write(path, { makeImage(300, 600, 0), current }, 1u, std::nullopt));
+
+        const auto thumb = ProjectFile::readThumbnail(path);
+        CHECK(thumb.size() == QSize{ ProjectFile::thumbnailSize, ProjectFile::thumbnailSize / 2 });
+        CHECK(thumb == current.scaled(thumb.size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation)
+                              .convertToFormat(thumb.format()));
+    }
+    SECTION("Small images are stored as they are")
+    {
+        REQUIRE(ProjectFile::write(path, { makeImage(16, 16, 0) }, 0u, std::nullopt));
+        CHECK(ProjectFile::readThumbnail(path) == makeImage(16, 16, 0));
+    }
+    SECTION("Invalid files")
+    {
+        CHECK(ProjectFile::readThumbnail(dir.filePath("missing.iep")).isNull());
+    }
+}
+
+TEST_CASE("Test invalid project files", "[persistence/projectfile]")
+{
+    auto dir = QTemporaryDir{};
+    REQUIRE(dir.isValid());
+    const auto path = dir.filePath("project.iep");
+
+    SECTION("Missing file")
+    {
+        CHECK(!ProjectFile::read(dir.filePath("missing.iep")));
+    }
+    SECTION("Not a project file")
+    {
+        auto file = QFile{ path };
+        REQUIRE(file.open(QIODevice::WriteOnly));
+        file.write(QByteArray{ 64, 'x' });
+        file.close();
+
+        CHECK(!ProjectFile::read(path));
+    }
+    SECTION("Truncated file")
+    {
+        REQUIRE(ProjectFile::write(path, { makeImage(300, 300, 0) }, 0u, std::nullopt));
+
+        auto file = QFile{ path };
+        REQUIRE(file.open(QIODevice::ReadWrite));
+        REQUIRE(file.resize(file.size() / 2));
+        file.close();
+
+        CHECK(!ProjectFile::read(path));
+    }
+    SECTION("Tiles beyond the end of the file")
+    {
+        // the offset and the length wrap around to a position inside the file
+        writeHostileFile(path, 16, 16, 1u, ~quint64{ 0 } - 15u, 32u);
+        CHECK(!ProjectFile::read(path));
+    }
+    SECTION("Oversized images")
+    {
+        // rejected before the tiles of 2^31 x 2^31 pixels are laid out
+        writeHostileFile(path, 0x7fffffff, 0x7fffffff, 1u, 8u, 1u);
+        CHECK(!ProjectFile::read(path));
+
+        writeHostileFile(path, 16, 16, 0xffffffffu, 8u, 1u);
+        CHECK(!ProjectFile::read(path));
+
+        writeHostileFile(path, -16, 16, 1u, 8u, 1u);
+        CHECK(!ProjectFile::read(path));
+    }
+    SECTION("Invalid history")
+    {
+        CHECK(!ProjectFile::write(path, {}, 0u, std::nullopt));
+        CHECK(!ProjectFile::write(path, { makeImage(16, 16, 0) }, 1u, std::nullopt));
+    }
+}
+
+TEST_CASE("Benchmark project file", "[.][benchmark][persistence/projectfile]")
+{
+    auto dir = QTemporaryDir{};
+    REQUIRE(dir.isValid());
+    const auto path = dir.filePath("project.iep");
+
+    const auto history = std::vector<QImage>(10u, makeImage(4096, 4096, 0));
+
+    BENCHMARK("Write 10 x 4096x4096")
+    {
+        return ProjectFile::write(path, history, 9u, std::nullopt);
+    };
+
+    REQUIRE(ProjectFile::write(path, history, 9u, std::nullopt));
+
+    BENCHMARK("Open 10 x 4096x4096")
+    {
+        return ProjectFile::read(path);
+    };
+
+    BENCHMARK("Open 10 x 4096x4096 and decode the whole history")
+    {
+        auto contents = ProjectFile::read(path);
+        for (const auto& img : contents->history)
+            (void)img.get();
+
+        return contents;
+    };
+
+    const auto png = dir.filePath("image.png");
+    REQUIRE(history.front().save(png));
+
+    BENCHMARK("Load 4096x4096 PNG for comparison")
+    {
+        return QImage{ png };
+    };
+}
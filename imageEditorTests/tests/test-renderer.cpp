@@ -0,0 +1,252 @@
+#include <catch.hpp>
+#include <colorengine.h>
+#include "fixtures.h"
+#include <offscreencontext.h>
+#include <renderer.h>
+#include <tonecurves.h>
+#include <vertexbuffer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QOpenGLTexture>
+
+namespace
+{
+    // uploaded the way the display uploads the background, without mirroring the rows
+    auto makeTexture(const QImage& image) -> std::unique_ptr<QOpenGLTexture>
+    {
+        auto texture = std::make_unique<QOpenGLTexture>(QOpenGLTexture::Target2D);
+
+        texture->setFormat(QOpenGLTexture::RGBA8_UNorm);
+        texture->setSize(image.width(), image.height());
+        texture->allocateStorage(QOpenGLTexture::BGRA, QOpenGLTexture::UInt32_RGBA8_Rev);
+        texture->setData(QOpenGLTexture::BGRA, QOpenGLTexture::UInt32_RGBA8_Rev, image.constBits());
+        texture->setMagnificationFilter(QOpenGLTexture::Nearest);
+        texture->setMinificationFilter(QOpenGLTexture::Nearest);
+        texture->setWrapMode(QOpenGLTexture::ClampToEdge);
+
+        return texture;
+    }
+
+    // a gray ramp with 16 bits per channel, a quarter of an 8-bit step from one pixel to the next, like the values
+    // a linearly filtered texture gives between its texels
+    auto makeRampTexture(int width) -> std::unique_ptr<QOpenGLTexture>
+    {
+        auto data = std::vector<quint16>(std::size_t(width) * 4u, 0xffffu);
+        for (int x = 0; x < width; ++x)
+            std::fill_n(data.begin() + x * 4, 3, static_cast<quint16>((x * 65535) / (width - 1)));
+
+        auto texture = std::make_unique<QOpenGLTexture>(QOpenGLTexture::Target2D);
+
+        texture->setFormat(QOpenGLTexture::RGBA16_UNorm);
+        texture->setSize(width, 1);
+        texture->allocateStorage(QOpenGLTexture::RGBA, QOpenGLTexture::UInt16);
+        texture->setData(QOpenGLTexture::RGBA, QOpenGLTexture::UInt16, data.data());
+        texture->setMagnificationFilter(QOpenGLTexture::Nearest);
+        texture->setMinificationFilter(QOpenGLTexture::Nearest);
+        texture->setWrapMode(QOpenGLTexture::ClampToEdge);
+
+        return texture;
+    }
+
+    // the quad covers the whole image, so it is drawn with the tile's matrix as it is
+    auto renderImage(Renderer& renderer, VertexBuffer& vbo, QOpenGLTexture& texture, const QSize& size,
+                     const ColorData& data, bool grayscale = false) -> QImage
+    {
+        return renderer.render(size, data, grayscale, [&](const QMatrix4x4& matrix) {
+            vbo.bindVbo();
+            texture.bind();
+            renderer.draw(matrix);
+        });
+    }
+
+    // the largest difference of a channel between the two images
+    auto maxDifference(const QImage& a, const QImage& b) -> int
+    {
+        auto worst = 0;
+        for (int y = 0; y < a.height(); ++y)
+        {
+            for (int x = 0; x < a.width(); ++x)
+            {
+                const auto p = a.pixel(x, y), q = b.pixel(x, y);
+                worst = std::max({ worst, std::abs(qRed(p) - qRed(q)), std::abs(qGreen(p) - qGreen(q)),
+                                   std::abs(qBlue(p) - qBlue(q)), std::abs(qAlpha(p) - qAlpha(q)) });
+            }
+        }
+
+        return worst;
+    }
+}
+
+// needs an OpenGL implementation, a software one will do; run it with "[gpu]"
+TEST_CASE("Test offscreen rendering", "[.][gpu][render/renderer]")
+{
+    const auto context = fixture::makeContext();
+    if (!context)
+    {
+        WARN("No OpenGL context is available");
+        return;
+    }
+
+    const auto image = fixture::makeImage(200, 150);
+    auto renderer = Renderer{};
+    auto vbo      = VertexBuffer::make();
+    auto texture  = makeTexture(image);
+
+    SECTION("Test the identity passes the pixels through")
+    {
+        const auto rendered = renderImage(renderer, *vbo, *texture, image.size(), ColorData{});
+
+        REQUIRE(rendered.size() == image.size());
+        CHECK(maxDifference(rendered, image) == 0);
+    }
+    SECTION("Test the color variants match the color engine")
+    {
+        for (const auto& data : { ColorData{ 0.3f, 0.5f, 0.8f, 0.0f, 1.0f }, ColorData{ 0.5f, 0.5f, 0.5f, 0.0f, 1.7f },
+                                  ColorData{ 0.5f, 0.5f, 0.5f, -0.2f, 1.0f }, ColorData{ 0.9f, 0.2f, 0.5f, 0.1f, 0.6f } })
+        {
+            const auto rendered = renderImage(renderer, *vbo, *texture, image.size(), data);
+
+            // the shader's float precision and the interpolated contrast curve may round a channel the other way
+            CHECK(maxDifference(rendered, ColorEngine::apply(image, data)) <= 1);
+        }
+    }
+    SECTION("Test the channel curves are interpolated between their entries")
+    {
+        // the same level for every channel keeps the ramp gray, which the round trip to YCbCr leaves as it is
+        const auto width = 255 * 4 + 1;
+        auto ramp = makeRampTexture(width);
+
+        for (const auto level : { 0.2f, 0.65f, 0.85f })
+        {
+            const auto rendered = renderImage(renderer, *vbo, *ramp, { width, 1 }, ColorData{ level, level, level, 0.0f, 1.0f });
+
+            auto worst = 0.0f;
+            for (int x = 0; x < width; ++x)
+            {
+                const auto expected = ToneCurves::channel(static_cast<float>(x) / static_cast<float>(width - 1), level) * 255.0f;
+                const auto pixel    = rendered.pixel(x, 0);
+                for (const auto channel : { qRed(pixel), qGreen(pixel), qBlue(pixel) })
+                    worst = std::max(worst, std::abs(static_cast<float>(channel) - expected));
+            }
+
+            // the 8-bit result rounds the curve, the shader's float precision may push it a little further
+            CHECK(worst <= 0.75f);
+        }
+    }
+    SECTION("Test grayscale")
+    {
+        const auto rendered = renderImage(renderer, *vbo, *texture, image.size(), ColorData{}, true);
+
+        for (const auto& point : { QPoint{ 0, 0 }, QPoint{ 100, 75 }, QPoint{ 199, 149 } })
+        {
+            const auto pixel = rendered.pixel(point);
+            CHECK(qRed(pixel) == qGreen(pixel));
+            CHECK(qGreen(pixel) == qBlue(pixel));
+        }
+    }
+    SECTION("Test tiles are stitched seamlessly")
+    {
+        auto tiled = Renderer{ 64 };
+        REQUIRE(tiled.getTileSize() == 64);
+
+        const auto data = ColorData{ 0.9f, 0.2f, 0.5f, 0.1f, 0.6f };
+        const auto whole = renderImage(renderer, *vbo, *texture, image.size(), data);
+        const auto tiles = renderImage(tiled, *vbo, *texture, image.size(), data);
+
+        CHECK(maxDifference(whole, tiles) == 0);
+    }
+    SECTION("Test the erased area is drawn black")
+    {
+        // the pixels [50, 150) x [30, 90) of the image
+        const auto erased = QRectF{ 0.25, 0.2, 0.5, 0.4 };
+        const auto rendered = renderer.render(image.size(), ColorData{}, false, [&](const QMatrix4x4& matrix) {
+            vbo->bindVbo();
+            texture->bind();
+            renderer.draw(matrix, erased);
+        });
+
+        for (const auto& point : { QPoint{ 50, 30 }, QPoint{ 100, 60 }, QPoint{ 149, 89 } })
+            CHECK(rendered.pixel(point) == qRgba(0x00, 0x00, 0x00, 0xff));
+
+        for (const auto& point : { QPoint{ 49, 60 }, QPoint{ 150, 60 }, QPoint{ 100, 29 }, QPoint{ 100, 90 } })
+            CHECK(rendered.pixel(point) == image.pixel(point));
+    }
+    SECTION("Test the frame covers only the border")
+    {
+        // drawn without blending, so that the shader's output is read back as it is, alpha included
+        const auto rendered = renderer.render(image.size(), ColorData{ 0.9f, 0.2f, 0.5f, 0.1f, 0.6f }, true,
+                                              [&](const QMatrix4x4& matrix) {
+            vbo->bindVbo();
+            renderer.drawFrame(matrix, image.size(), Renderer::frameColor, Renderer::frameWidth);
+        });
+
+        // the color operations do not apply to the frame
+        for (const auto& point : { QPoint{ 0, 0 }, QPoint{ 3, 75 }, QPoint{ 100, 146 }, QPoint{ 199, 149 } })
+            CHECK(rendered.pixel(point) == Renderer::frameColor);
+
+        // the framebuffer is cleared to transparent black, which the frame leaves as it is inside the border
+        for (const auto& point : { QPoint{ 4, 4 }, QPoint{ 100, 75 }, QPoint{ 195, 145 } })
+            CHECK(rendered.pixel(point) == qRgba(0x00, 0x00, 0x00, 0x00));
+    }
+}
+
+TEST_CASE("Benchmark offscreen rendering", "[.][benchmark][render/renderer]")
+{
+    const auto context = fixture::makeContext();
+    if (!context)
+    {
+        WARN("No OpenGL context is available");
+        return;
+    }
+
+    const auto image = fixture::makeImage(2048, 2048);
+    const auto data  = ColorData{ 0.3f, 0.5f, 0.8f, 0.1f, 1.7f };
+    auto renderer = Renderer{};
+    auto vbo      = VertexBuffer::make();
+    auto texture  = makeTexture(image);
+
+    BENCHMARK("Render 2048x2048, identity")
+    {
+        return renderImage(renderer, *vbo, *texture, image.size(), ColorData{});
+    };
+
+    BENCHMARK("Render 2048x2048, all color stages")
+    {
+        return renderImage(renderer, *vbo, *texture, image.size(), data);
+    };
+
+    BENCHMARK("Color engine 2048x2048, all color stages")
+    {
+        return ColorEngine::apply(image, data);
+    };
+}
+
+// Qt checks the attribute once per context, so every run gets a context of its own; the first run with the
+// cache enabled fills it, the ones after it measure loading the linked programs instead of building them
+TEST_CASE("Benchmark shader startup", "[.][benchmark][render/renderer]")
+{
+    for (const auto disabled : { true, false })
+    {
+        QCoreApplication::setAttribute(Qt::AA_DisableShaderDiskCache, disabled);
+
+        const auto context = fixture::makeContext();
+        if (!context)
+        {
+            WARN("No OpenGL context is available");
+            break;
+        }
+
+        BENCHMARK(std::string{ "Build the renderer, shader disk cache " } + (disabled ? "disabled" : "enabled"))
+        {
+            const auto renderer = Renderer{};
+        };
+    }
+
+    QCoreApplication::setAttribute(Qt::AA_DisableShaderDiskCache, false);
+}
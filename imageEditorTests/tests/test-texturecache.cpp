@@ -0,0 +1,104 @@
+#include <catch.hpp>
+#include <texturecache.h>
+
+#include <vector>
+
+namespace
+{
+    // the textures are never created, so no GL context is needed for them
+    auto makeTexture() -> util::owner_ptr<QOpenGLTexture>
+    {
+        return util::make_owner<QOpenGLTexture>(QOpenGLTexture::Target2D);
+    }
+}
+
+TEST_CASE("Test texture cache", "[render/texturecache]")
+{
+    auto released = std::vector<QOpenGLTexture*>{};
+    const auto release = [&](util::owner_ptr<QOpenGLTexture> texture) {
+        released.push_back(texture.get());
+        texture.reset();
+    };
+
+    SECTION("Hits and misses")
+    {
+        auto cache = TextureCache{ 100, release };
+
+        auto texture = makeTexture();
+        const auto raw = texture.get();
+        cache.insert(1, std::move(texture), 40);
+
+        CHECK(!cache.take(2));
+
+        auto taken = cache.take(1);
+        CHECK(taken.get() == raw);
+        CHECK(!cache.take(1));
+        taken.reset();
+
+        const auto stats = cache.stats();
+        CHECK(stats.hits == 1u);
+        CHECK(stats.misses == 2u);
+        CHECK(stats.images == 0u);
+        CHECK(stats.bytes == 0u);
+        CHECK(released.empty());
+    }
+    SECTION("The least recently used textures are evicted")
+    {
+        auto cache = TextureCache{ 100, release };
+
+        auto first = makeTexture();
+        const auto firstRaw = first.get();
+        cache.insert(1, std::move(first), 40);
+        cache.insert(2, makeTexture(), 40);
+
+        // taking the first one and putting it back makes the second one the least recently used
+        cache.insert(1, cache.take(1), 40);
+
+        auto third = makeTexture();
+        const auto thirdRaw = third.get();
+        cache.insert(3, std::move(third), 40);
+
+        REQUIRE(released.size() == 1u);
+        CHECK(!cache.take(2));
+
+        auto taken = cache.take(1);
+        CHECK(taken.get() == firstRaw);
+        taken.reset();
+
+        taken = cache.take(3);
+        CHECK(taken.get() == thirdRaw);
+        taken.reset();
+    }
+    SECTION("A texture larger than the budget is released right away")
+    {
+        auto cache = TextureCache{ 100, release };
+
+        cache.insert(1, makeTexture(), 101);
+
+        CHECK(released.size() == 1u);
+        CHECK(cache.stats().images == 0u);
+    }
+    SECTION("Inserting a key again replaces its texture")
+    {
+        auto cache = TextureCache{ 100, release };
+
+        auto old = makeTexture();
+        const auto oldRaw = old.get();
+        cache.insert(1, std::move(old), 40);
+        cache.insert(1, makeTexture(), 40);
+
+        REQUIRE(released.size() == 1u);
+        CHECK(released.front() == oldRaw);
+        CHECK(cache.stats().bytes == 40u);
+    }
+    SECTION("Every texture is released when the cache is destroyed")
+    {
+        {
+            auto cache = TextureCache{ 100, release };
+            cache.insert(1, makeTexture(), 40);
+            cache.insert(2, makeTexture(), 40);
+        }
+
+        CHECK(released.size() == 2u);
+    }
+}
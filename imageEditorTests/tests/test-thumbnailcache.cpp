@@ -0,0 +1,73 @@
+#include <catch.hpp>
+#include <projectfile.h>
+#include <thumbnailcache.h>
+
+#include <chrono>
+#include <thread>
+#include <QDir>
+#include <QTemporaryDir>
+
+TEST_CASE("Test thumbnail cache", "[persistence/thumbnailcache]")
+{
+    auto dir = QTemporaryDir{};
+    REQUIRE(dir.isValid());
+
+    const auto cache = ThumbnailCache{ dir.filePath("thumbnails") };
+    const auto path  = dir.filePath("image.png");
+
+    auto img = QImage{ 1000, 500, QImage::Format_ARGB32 };
+    img.fill(Qt::red);
+    REQUIRE(img.save(path));
+
+    SECTION("Thumbnails are scaled and stored")
+    {
+        CHECK(!cache.lookup(path));
+
+        const auto thumb = cache.thumbnail(path);
+        REQUIRE(thumb);
+        CHECK(thumb->width() == ThumbnailCache::thumbnailSize);
+        CHECK(thumb->height() == ThumbnailCache::thumbnailSize / 2);
+
+        const auto cached = cache.lookup(path);
+        REQUIRE(cached);
+        CHECK(cached->size() == thumb->size());
+        CHECK(QDir{ dir.filePath("thumbnails") }.entryList(QDir::Files).size() == 1);
+    }
+    SECTION("Small images are not scaled up")
+    {
+        const auto small = dir.filePath("small.png");
+        REQUIRE(img.scaled(20, 10).save(small));
+
+        const auto thumb = cache.thumbnail(small);
+        REQUIRE(thumb);
+        CHECK(thumb->size() == QSize{ 20, 10 });
+    }
+    SECTION("Changed files are invalidated")
+    {
+        REQUIRE(cache.thumbnail(path));
+
+        // make sure the modification time changes, even on file systems with a coarse resolution
+        std::this_thread::sleep_for(std::chrono::milliseconds{ 1100 });
+        REQUIRE(img.scaled(400, 400).save(path));
+
+        CHECK(!cache.lookup(path));
+
+        const auto thumb = cache.thumbnail(path);
+        REQUIRE(thumb);
+        CHECK(thumb->size() == QSize{ ThumbnailCache::thumbnailSize, ThumbnailCache::thumbnailSize });
+    }
+    SECTION("Projects")
+    {
+        const auto project = dir.filePath("project." + ProjectFile::suffix);
+        REQUIRE(ProjectFile::write(project, { img }, 0u, std::nullopt));
+
+        const auto thumb = cache.thumbnail(project);
+        REQUIRE(thumb);
+        CHECK(thumb->width() == ThumbnailCache::thumbnailSize);
+    }
+    SECTION("Invalid files")
+    {
+        CHECK(!cache.thumbnail(dir.filePath("missing.png")));
+        CHECK(!cache.lookup(dir.filePath("missing.png")));
+    }
+}
@@ -0,0 +1,85 @@
+#include <catch.hpp>
+#include "fixtures.h"
+#include <tilepyramid.h>
+
+TEST_CASE("Test tile pyramid", "[render/tilepyramid]")
+{
+    SECTION("The levels are halved until one fits into a tile")
+    {
+        const auto pyramid = TilePyramid{ fixture::makeImage(1000, 600), 256 };
+
+        REQUIRE(pyramid.getLevelCount() == 3);
+        CHECK(pyramid.getLevel(0).size() == QSize{ 1000, 600 });
+        CHECK(pyramid.getLevel(1).size() == QSize{ 500, 300 });
+        CHECK(pyramid.getLevel(2).size() == QSize{ 250, 150 });
+
+        CHECK(pyramid.getTileCount(0) == QSize{ 4, 3 });
+        CHECK(pyramid.getTileCount(2) == QSize{ 1, 1 });
+    }
+    SECTION("Odd sizes are rounded up")
+    {
+        const auto pyramid = TilePyramid{ fixture::makeImage(513, 257), 256 };
+
+        REQUIRE(pyramid.getLevelCount() == 3);
+        CHECK(pyramid.getLevel(1).size() == QSize{ 257, 129 });
+        CHECK(pyramid.getLevel(2).size() == QSize{ 129, 65 });
+    }
+    SECTION("The tiles on the edges are smaller")
+    {
+        const auto pyramid = TilePyramid{ fixture::makeImage(1000, 600), 256 };
+
+        CHECK(pyramid.getTileRect(0, 0, 0) == QRect{ 0, 0, 256, 256 });
+        CHECK(pyramid.getTileRect(0, 3, 2) == QRect{ 768, 512, 232, 88 });
+        CHECK(pyramid.getTileRect(1, 1, 1) == QRect{ 256, 256, 244, 44 });
+    }
+    SECTION("Rects are converted between the levels")
+    {
+        const auto pyramid = TilePyramid{ fixture::makeImage(1000, 600), 256 };
+
+        CHECK(pyramid.toImageRect(1, QRectF{ 0.0, 0.0, 250.0, 150.0 }) == QRectF{ 0.0, 0.0, 500.0, 300.0 });
+        CHECK(pyramid.toLevelRect(2, QRectF{ 400.0, 200.0, 400.0, 400.0 }) == QRectF{ 100.0, 50.0, 100.0, 100.0 });
+    }
+    SECTION("The level is chosen by the zoom")
+    {
+        const auto pyramid = TilePyramid{ fixture::makeImage(1000, 600), 256 };
+
+        CHECK(pyramid.levelForZoom(1.0f) == 0);
+        CHECK(pyramid.levelForZoom(4.0f) == 0);
+        CHECK(pyramid.levelForZoom(0.5f) == 1);
+        CHECK(pyramid.levelForZoom(0.6f) == 1);
+        CHECK(pyramid.levelForZoom(0.25f) == 2);
+        CHECK(pyramid.levelForZoom(0.01f) == 2);
+    }
+    SECTION("Halving averages four pixels")
+    {
+        auto img = QImage{ 3, 2, QImage::Format_ARGB32 };
+        img.setPixel(0, 0, qRgba(0, 0, 0, 0xff));
+        img.setPixel(1, 0, qRgba(10, 20, 30, 0xff));
+        img.setPixel(0, 1, qRgba(20, 40, 60, 0xff));
+        img.setPixel(1, 1, qRgba(30, 60, 90, 0xff));
+        img.setPixel(2, 0, qRgba(100, 0, 0, 0x80));
+        img.setPixel(2, 1, qRgba(200, 0, 0, 0x80));
+
+        const auto half = TilePyramid::halve(img);
+
+        REQUIRE(half.size() == QSize{ 2, 1 });
+        CHECK(half.pixel(0, 0) == qRgba(15, 30, 45, 0xff));
+
+        // the last column has no neighbour, so it is averaged with itself
+        CHECK(half.pixel(1, 0) == qRgba(150, 0, 0, 0x80));
+    }
+    SECTION("Tiles have a border of their neighbours' pixels")
+    {
+        const auto image = fixture::makeImage(300, 10);
+        const auto pyramid = TilePyramid{ image, 256 };
+        const auto tile = pyramid.extractTile(0, 1, 0);
+
+        REQUIRE(tile.size() == QSize{ 46, 12 });
+        CHECK(tile.pixel(1, 1) == image.pixel(256, 0));
+        CHECK(tile.pixel(0, 1) == image.pixel(255, 0));
+
+        // beyond the edges of the level, the pixels on them are repeated
+        CHECK(tile.pixel(0, 0) == image.pixel(255, 0));
+        CHECK(tile.pixel(45, 11) == image.pixel(299, 9));
+    }
+}
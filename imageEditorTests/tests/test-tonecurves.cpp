@@ -0,0 +1,105 @@
+#include "catch.hpp"
+#include <colorengine.h>
+#include <tonecurves.h>
+#include <util.h>
+
+#include <algorithm>
+#include <cstdlib>
+
+using namespace util::types;
+
+namespace
+{
+    // the same lookups as the display's color shader
+    auto lookupPixel(QRgb pixel, const ToneCurves& curves, float bright) -> QRgb
+    {
+        const auto r = curves.getRed()[std::size_t(qRed(pixel))];
+        const auto g = curves.getGreen()[std::size_t(qGreen(pixel))];
+        const auto b = curves.getBlue()[std::size_t(qBlue(pixel))];
+
+        const auto half = 128.0f / 255.0f;
+        const auto y  = std::clamp( 0.299f  * r + 0.587f  * g + 0.114f  * b,        0.0f, 1.0f);
+        const auto cb = std::clamp(-0.1687f * r - 0.3313f * g + 0.5f    * b + half, 0.0f, 1.0f);
+        const auto cr = std::clamp( 0.5f    * r - 0.4187f * g - 0.0813f * b + half, 0.0f, 1.0f);
+
+        const auto y2  = curves.sampleContrast(y) + bright;
+        const auto cb2 = curves.sampleContrast(cb) - half;
+        const auto cr2 = curves.sampleContrast(cr) - half;
+
+        const auto toChannel = [](float ch) { return util::round(std::clamp(ch, 0.0f, 1.0f) * 255.0f); };
+        return qRgba(toChannel(y2 + 1.402f * cr2),
+                     toChannel(y2 - 0.3441f * cb2 - 0.7141f * cr2),
+                     toChannel(y2 + 1.722f * cb2),
+                     qAlpha(pixel));
+    }
+}
+
+TEST_CASE("Test tone curves", "[common/tonecurves]")
+{
+    const auto data = ColorData{ 0.3f, 0.5f, 0.8f, 0.1f, 1.7f };
+    const auto curves = ToneCurves{ data };
+
+    SECTION("Test the tables sample the curves")
+    {
+        REQUIRE(curves.getRed().size() == std::size_t(ToneCurves::channelSize));
+        REQUIRE(curves.getContrast().size() == std::size_t(ToneCurves::contrastSize));
+
+        for (int i = 0; i < ToneCurves::channelSize; ++i)
+        {
+            const auto ch = toFloat(i) / 255.0f;
+            const auto index = std::size_t(i);
+
+            CHECK(curves.getRed()[index] == Approx(ToneCurves::channel(ch, data.red)));
+            CHECK(curves.getGreen()[index] == Approx(ch).margin(1e-6));
+            CHECK(curves.getBlue()[index] == Approx(ToneCurves::channel(ch, data.blue)));
+        }
+    }
+    SECTION("Test the contrast curve is interpolated")
+    {
+        CHECK(curves.sampleContrast(0.0f) == Approx(0.0f).margin(1e-6));
+        CHECK(curves.sampleContrast(0.5f) == Approx(0.5f).margin(1e-4));
+        CHECK(curves.sampleContrast(1.0f) == Approx(1.0f).margin(1e-6));
+
+        for (const auto ch : { 0.1f, 0.3337f, 0.71f, 0.999f })
+            CHECK(curves.sampleContrast(ch) == Approx(ToneCurves::contrast(ch, data.contrast)).margin(1e-4));
+    }
+    SECTION("Test zero contrast is finite")
+    {
+        const auto flat = ToneCurves{ ColorData{ 0.5f, 0.5f, 0.5f, 0.0f, 0.0f } };
+
+        CHECK(flat.sampleContrast(0.2f) == Approx(0.5f));
+        CHECK(flat.sampleContrast(0.9f) == Approx(0.5f));
+    }
+}
+
+TEST_CASE("Test tone curve lookups match the color engine", "[common/tonecurves]")
+{
+    for (const auto& data : { ColorData{}, ColorData{ 0.3f, 0.5f, 0.8f, 0.1f, 1.7f },
+                              ColorData{ 0.9f, 0.2f, 0.5f, -0.2f, 0.6f }, ColorData{ 0.5f, 0.6f, 0.4f, 0.0f, 3.0f } })
+    {
+        SECTION("Contrast " + std::to_string(data.contrast) + ", bright " + std::to_string(data.bright))
+        {
+            const auto curves = ToneCurves{ data };
+
+            // the interpolation of the contrast curve may round a channel the other way
+            auto worst = 0;
+            for (int r = 0; r < 256; r += 15)
+            {
+                for (int g = 0; g < 256; g += 15)
+                {
+                    for (int b = 0; b < 256; b += 15)
+                    {
+                        const auto expected = ColorEngine::applyPixel(qRgb(r, g, b), data);
+                        const auto actual   = lookupPixel(qRgb(r, g, b), curves, data.bright);
+
+                        worst = std::max({ worst, std::abs(qRed(expected) - qRed(actual)),
+                                           std::abs(qGreen(expected) - qGreen(actual)),
+                                           std::abs(qBlue(expected) - qBlue(actual)) });
+                    }
+                }
+            }
+
+            CHECK(worst <= 1);
+        }
+    }
+}
@@ -1,6 +1,10 @@
 #include "catch.hpp"
 #include <util.h>
 
+#include <atomic>
+#include <thread>
+#include <vector>
+
 TEST_CASE("Test clamp", "[util/clamp]")
 {
     CHECK(util::clamp(-1 , 0, 255) == 0);
@@ -69,3 +73,61 @@ TEST_CASE("Test history", "[util/history]")
         REQUIRE(hist.undo() == 6u);
     }
 }
+
+TEST_CASE("Test parallel_for", "[util/parallel_for]")
+{
+    auto visited = std::vector<std::atomic_int>(1000u);
+
+    util::parallel_for(visited.size(), [&](std::size_t i) { ++visited[i]; });
+
+    for (const auto& v : visited)
+        REQUIRE(v == 1);
+
+    SECTION("Test serial_scope")
+    {
+        auto threads = std::vector<std::thread::id>(100u);
+        {
+            const auto serial = util::serial_scope{};
+            util::parallel_for(threads.size(), [&](std::size_t i) { threads[i] = std::this_thread::get_id(); });
+        }
+
+        CHECK(!util::serial_scope::isActive());
+        for (const auto& id : threads)
+            REQUIRE(id == std::this_thread::get_id());
+    }
+}
+
+TEST_CASE("Test blocking_queue", "[util/blocking_queue]")
+{
+    SECTION("Test order and close")
+    {
+        auto queue = util::blocking_queue<int>{ 3u };
+
+        REQUIRE(queue.push(1));
+        REQUIRE(queue.push(2));
+        queue.close();
+
+        REQUIRE_FALSE(queue.push(3));
+        REQUIRE(queue.pop() == 1);
+        REQUIRE(queue.pop() == 2);
+        REQUIRE_FALSE(queue.pop().has_value());
+    }
+    SECTION("Test producer and consumer")
+    {
+        auto queue = util::blocking_queue<int>{ 2u };
+        auto sum   = 0;
+
+        auto consumer = std::thread{ [&] {
+            while (auto value = queue.pop())
+                sum += *value;
+        }};
+
+        for (int i = 1; i <= 100; ++i)
+            REQUIRE(queue.push(i));
+
+        queue.close();
+        consumer.join();
+
+        REQUIRE(sum == 5050);
+    }
+}
@@ -0,0 +1,137 @@
+#include <catch.hpp>
+#include "fixtures.h"
+#include <renderer.h>
+#include <vertexbuffer.h>
+#include <virtualtexture.h>
+
+#include <memory>
+#include <vector>
+
+namespace
+{
+    // the area of the image the tiles cover, they do not overlap
+    auto coveredArea(const std::vector<VirtualTexture::Tile>& tiles) -> double
+    {
+        auto area = 0.0;
+        for (const auto& tile : tiles)
+            area += tile.imageRect.width() * tile.imageRect.height();
+
+        return area;
+    }
+
+    // an atlas of 7 x 7 slots
+    const int atlasSize{ 7 * (VirtualTexture::tileSize + 2) };
+}
+
+// needs an OpenGL implementation, a software one will do; run it with "[gpu]"
+TEST_CASE("Test virtual texture", "[.][gpu][render/virtualtexture]")
+{
+    const auto context = fixture::makeContext();
+    if (!context)
+    {
+        WARN("No OpenGL context is available");
+        return;
+    }
+
+    SECTION("Missing tiles are drawn from a coarser level")
+    {
+        // 4 x 3 tiles in the first level, but only 8 slots besides the coarsest tile
+        auto texture = VirtualTexture{ fixture::makeImage(1000, 600), 3 * (VirtualTexture::tileSize + 2) };
+        const auto image = QRectF{ 0.0, 0.0, 1000.0, 600.0 };
+
+        const auto tiles = texture.prepare(image, 1.0f);
+        CHECK(coveredArea(tiles) == Approx(1000.0 * 600.0));
+        CHECK(!texture.hasPendingTiles());
+
+        auto stats = texture.stats();
+        CHECK(stats.images == 9u);
+        CHECK(stats.misses == 12u);
+
+        // the tiles of the frame are not evicted for the others
+        texture.prepare(image, 1.0f);
+        stats = texture.stats();
+        CHECK(stats.hits == 8u);
+        CHECK(stats.misses == 16u);
+    }
+    SECTION("Virtual textures of the same image share its pyramid")
+    {
+        const auto pyramid = std::make_shared<const TilePyramid>(fixture::makeImage(1000, 600), VirtualTexture::tileSize);
+        const auto first  = VirtualTexture{ pyramid, atlasSize };
+        const auto second = VirtualTexture{ pyramid, atlasSize };
+
+        CHECK(&first.getPyramid() == pyramid.get());
+        CHECK(&second.getPyramid() == pyramid.get());
+        CHECK(pyramid.use_count() == 3);
+    }
+    SECTION("The least recently used tiles are evicted")
+    {
+        auto texture = VirtualTexture{ fixture::makeImage(1000, 600), 3 * (VirtualTexture::tileSize + 2) };
+
+        // the top, the bottom and then the middle row of the first level, the middle one evicts the top one
+        texture.prepare(QRectF{ 0.0, 0.0, 1000.0, 256.0 }, 1.0f);
+        texture.prepare(QRectF{ 0.0, 512.0, 1000.0, 88.0 }, 1.0f);
+        texture.prepare(QRectF{ 0.0, 256.0, 1000.0, 256.0 }, 1.0f);
+        CHECK(texture.stats().misses == 12u);
+
+        texture.prepare(QRectF{ 0.0, 512.0, 1000.0, 88.0 }, 1.0f);
+        CHECK(texture.stats().hits == 4u);
+
+        texture.prepare(QRectF{ 0.0, 0.0, 1000.0, 256.0 }, 1.0f);
+        CHECK(texture.stats().misses == 16u);
+    }
+    SECTION("The uploads of a frame are limited")
+    {
+        // 8 x 6 tiles in the first level, which fit into the atlas along with the coarsest one
+        auto texture = VirtualTexture{ fixture::makeImage(2048, 1536), atlasSize };
+        const auto image = QRectF{ 0.0, 0.0, 2048.0, 1536.0 };
+
+        for (int frame = 0; frame < 3; ++frame)
+        {
+            const auto tiles = texture.prepare(image, 1.0f);
+            CHECK(coveredArea(tiles) == Approx(2048.0 * 1536.0));
+            CHECK(texture.hasPendingTiles() == (frame < 2));
+        }
+
+        CHECK(texture.stats().images == 49u);
+
+        texture.prepare(image, 1.0f);
+        CHECK(texture.stats().hits == 16u + 32u + 48u);
+        CHECK(!texture.hasPendingTiles());
+    }
+    SECTION("The tiles are stitched seamlessly")
+    {
+        const auto image = fixture::makeImage(1000, 600);
+        auto texture = VirtualTexture{ image, atlasSize };
+        const auto tiles = texture.prepare(QRectF{ image.rect() }, 1.0f);
+
+        auto renderer = Renderer{};
+        auto vbo = VertexBuffer::make();
+
+        // each tile's quad is the default one, moved onto the tile's part of the image, like the display draws it
+        const auto rendered = renderer.render(image.size(), ColorData{}, false, [&](const QMatrix4x4& matrix) {
+            vbo->bindVbo();
+            texture.getAtlas().bind();
+
+            for (const auto& tile : tiles)
+            {
+                const auto& rect = tile.imageRect;
+
+                auto model = QMatrix4x4{};
+                model.translate(static_cast<float>(2.0 * rect.center().x() / 1000.0 - 1.0),
+                                static_cast<float>(2.0 * rect.center().y() / 600.0 - 1.0));
+                model.scale(static_cast<float>(rect.width() / 1000.0), static_cast<float>(rect.height() / 600.0));
+
+                renderer.draw(matrix * model, {}, tile.atlasRect);
+            }
+        });
+
+        REQUIRE(rendered.size() == image.size());
+
+        auto differing = 0;
+        for (int y = 0; y < image.height(); ++y)
+            for (int x = 0; x < image.width(); ++x)
+                differing += rendered.pixel(x, y) != image.pixel(x, y);
+
+        CHECK(differing == 0);
+    }
+}